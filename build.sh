@@ -1,2 +1,4 @@
 #!/bin/sh
-gcc -o reversi src/reversi.c src/reversi_functions.c src/team03.c rivals/teamnaive.c rivals/teamrand.c
+# Extra compiler flags can be passed through CFLAGS; the x86 kernels are
+# picked at runtime, so no -march is needed for them
+gcc ${CFLAGS} -pthread -o reversi src/reversi.c src/reversi_functions.c src/team03.c rivals/teamnaive.c rivals/teamrand.c
@@ -25,6 +25,102 @@
 #   define VT100_CLEAR_LINE "\033[A\33[2K"
 #endif
 
+// Toggle runtime ISA dispatch for the board kernels (popcount, move
+// generation, flips, mobility). When on, the best variant the CPU
+// supports is picked once at startup from CPUID; when off (or on non-x86
+// compilers), only the portable scalar kernels are used
+#define TEAM03_DISPATCH 1
+
+// Force a flip kernel instead of picking one by CPU, for benchmarking:
+// the per-square ray tables, the AVX2 fills or the BMI2 line tables.
+// Falls back to the ray tables if the CPU doesn't support the choice.
+#define TEAM03_FLIP_AUTO 0
+#define TEAM03_FLIP_RAYS 1
+#define TEAM03_FLIP_AVX2 2
+#define TEAM03_FLIP_PEXT 3
+#define TEAM03_FLIP_BACKEND TEAM03_FLIP_AUTO
+
+// Default transposition table size (MB); the TEAM03_HASH_MB environment
+// variable overrides it at startup, up to TEAM03_HASH_MAX_MB
+#define TEAM03_HASH_MB 64
+#define TEAM03_HASH_MAX_MB 16384
+
+// Number of search threads (Lazy SMP) on POSIX; 0 uses every online core.
+// The TEAM03_THREADS environment variable overrides it at startup
+#define TEAM03_THREADS 0
+#define TEAM03_MAX_THREADS 64
+
+// Parallel search backend: Lazy SMP (helpers run their own iterative
+// deepening and share the transposition table) or Young Brothers Wait
+// (nodes are split between threads once their eldest child is searched).
+// The TEAM03_PARALLEL environment variable ("lazy"/"ybwc") overrides it
+#define TEAM03_PARALLEL TEAM03_PARALLEL_LAZY
+
+// Toggle Principal Variation Search: only the first move at each node
+// gets the full window; the rest are null-window searched and re-searched
+// only if they turn out better. The TEAM03_PVS environment variable
+// ("0"/"1") overrides it at startup
+#define TEAM03_USE_PVS 1
+
+// Toggle pondering: after each move, a background thread searches the
+// opponent's replies until `team03Move` is called again, filling the
+// transposition table. The TEAM03_PONDER environment variable ("0"/"1")
+// overrides it at startup
+#define TEAM03_PONDER 1
+
+// Aspiration windows: from this depth on, each iteration first searches
+// a window of +/- TEAM03_ASPIRATION_WINDOW around the score from two depths
+// back, doubling the failing side's margin until the score fits
+#define TEAM03_ASPIRATION_MIN_LAYER 3
+#define TEAM03_ASPIRATION_WINDOW 16
+#define TEAM03_ASPIRATION_MAX_WINDOW 256
+
+// Minimum remaining depth for a YBWC split, and minimum empties for one
+// in the endgame solver; smaller subtrees are too cheap to be worth
+// handing to another thread
+#define TEAM03_YBWC_MIN_LAYER 3
+#define TEAM03_YBWC_MIN_EMPTIES 12
+
+// Nodes with at least this many layers left and no table move rank their
+// moves with a shallow search of TEAM03_RANK_LAYERS (counting the move)
+// instead of the staged picker; the search costs little next to the subtree
+#define TEAM03_RANK_MIN_LAYER 5
+#define TEAM03_RANK_LAYERS 2
+
+// Endgame solving: with TEAM03_WLD_EMPTIES empties or fewer, the
+// outcome (win/loss/draw) is proven after an iterative deepening
+// heuristic search of at least TEAM03_ENDGAME_PRESEARCH layers, which
+// goes deeper while it has used under TEAM03_ENDGAME_DEEPEN_SHARE % of
+// the move's time; with TEAM03_ENDGAME_EMPTIES or fewer, the exact
+// score follows. Above TEAM03_ENDGAME_FASTEST empties the solver orders
+// moves fastest first; from TEAM03_ENDGAME_TT_MIN empties on it uses
+// the table, and from TEAM03_ENDGAME_STABILITY_MIN on it tries
+// stability cutoffs.
+#define TEAM03_WLD_EMPTIES 22
+#define TEAM03_ENDGAME_EMPTIES 20
+#define TEAM03_ENDGAME_PRESEARCH 6
+#define TEAM03_ENDGAME_DEEPEN_SHARE 25
+#define TEAM03_ENDGAME_FASTEST 5
+#define TEAM03_ENDGAME_TT_MIN 8
+#define TEAM03_ENDGAME_STABILITY_MIN 5
+
+// Evaluation weights file written by the tuner (tools/tune.c), loaded at
+// startup if it's there; the hand-made weights are used otherwise. The
+// TEAM03_WEIGHTS environment variable overrides the path
+#define TEAM03_WEIGHTS_FILE "team03.weights"
+
+// The timer thread raises the stop flag at the deadline; each search
+// thread also checks the clock itself every this many nodes (power of 2),
+// in case there's no timer thread
+#define TEAM03_POLL_NODES 4096
+#define TEAM03_NO_DEADLINE (1ll << 62)
+
+// Search statistics: after each move, a JSON line summing up the search
+// (nodes, cutoffs, table hits and time per iteration) is appended to this
+// file; "-" is stderr, and NULL turns it off. The TEAM03_STATS environment
+// variable overrides it at startup
+#define TEAM03_STATS_FILE NULL
+
 // Check if GCC optimizations are available
 #if (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7) || defined(__clang__))
 #   define GCC_OPTIM_AVAILABLE
@@ -45,14 +141,24 @@
 // General includes for all platforms
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 #include "team03.h"
 
+// Only build the ISA variants if we're dispatching between them
+#if TEAM03_DISPATCH && defined(TEAM03_IS_X86)
+#   define TEAM03_X86_KERNELS
+#endif
+
 // <sys/time>'s gettimeofday function only exists on POSIX, so if
 // we're running windows, we instead include its headers and
 // reimplement gettimeofday below
 #ifdef TEAM03_IS_POSIX
 #   include <sys/time.h>
+#   include <time.h>
+#   include <pthread.h>
+#   include <sched.h>
+#   include <unistd.h>
 #else
 #   undef SIZE
 //  ^ The windows header has a macro called SIZE, so we need to make
@@ -66,9 +172,196 @@
 // Constants & global variables for move timing
 const int team03_timePadding = 20; // padding (ms) for search timer
 const int team03_maxLayers = 24; // max depth of iterative search
+#define TEAM03_MAX_LAYERS 24 // (same, for sizing arrays)
 long long team03_maxTime = 5000; // max time (ms) per move; overwritten later
 struct timeval team03_startTime; // start time of the current move
 
+// File masks for discarding bits that wrap around the board edge after a
+// horizontal or diagonal shift (A = column 0, H = column 7)
+#define TEAM03_NOT_A_FILE 0xfefefefefefefefeull
+#define TEAM03_NOT_H_FILE 0x7f7f7f7f7f7f7f7full
+#define TEAM03_CORNERS 0x8100000000000081ull
+
+// Default static evaluation weights per move of mobility advantage, for
+// parity (having the last move) and per stable disc of advantage;
+// evaluation scores (pattern weights included) are in eighths of a disc.
+// A weights file can set them by phase
+#define TEAM03_MOBILITY_WEIGHT 16
+#define TEAM03_PARITY_WEIGHT 0
+#define TEAM03_STABLE_WEIGHT 8
+
+// Weights file layout: the magic, then little-endian int32s: the version,
+// phase count and table size, the mobility, parity and stability weights
+// by phase, and the pattern tables by phase. Version 1 files have no
+// stability weights; they load with the current ones kept
+#define TEAM03_WEIGHTS_MAGIC "T03W"
+#define TEAM03_WEIGHTS_VERSION 2
+
+// Evaluation patterns: 8 types, 34 instances in all (the types' symmetric
+// images on the board). Each type has a table per phase indexed by the
+// base-3 code of its squares (0 empty, 1 black, 2 white); its instances
+// share it. The tables for all types sit end to end; the sizes are in
+// team03.h, which the tuner shares.
+#define TEAM03_PATTERN_TYPES 8
+#define TEAM03_PATTERN_EDGE 0 // an edge plus its two X squares
+#define TEAM03_PATTERN_CORNER25 1 // 2x5 corner block
+#define TEAM03_PATTERN_CORNER33 2 // 3x3 corner block
+#define TEAM03_PATTERN_DIAG8 3 // the diagonals of 8 squares down to 4
+#define TEAM03_PATTERN_DIAG4 7
+const int team03_patternSizes[TEAM03_PATTERN_TYPES] = { 10, 10, 9, 8, 7, 6, 5, 4 };
+const int team03_patternTypes[TEAM03_PATTERNS] = {
+        0, 0, 0, 0,
+        1, 1, 1, 1, 1, 1, 1, 1,
+        2, 2, 2, 2,
+        3, 3,
+        4, 4, 4, 4,
+        5, 5, 5, 5,
+        6, 6, 6, 6,
+        7, 7, 7, 7
+};
+
+// Pattern lookup tables: each instance's squares (by digit) and table
+// offset, the base-3 value of each 10-bit binary number, the phase for
+// each disc count, and the weights themselves. The weights are int16s
+// (two phases of tables fit in L2), with each phase's tables together
+int8_t team03_patternSquares[TEAM03_PATTERNS][10];
+int team03_patternOffsets[TEAM03_PATTERNS];
+uint16_t team03_base3[1024];
+int8_t team03_squarePatterns[64][8]; // the instances covering each square...
+uint16_t team03_squarePowers[64][8]; // ...and the square's digit value in each
+int team03_squarePatternCount[64];
+int team03_evalPhase[65];
+int16_t team03_evalTable[TEAM03_EVAL_PHASES][TEAM03_PATTERN_TABLE_STRIDE];
+int team03_mobilityWeights[TEAM03_EVAL_PHASES];
+int team03_parityWeights[TEAM03_EVAL_PHASES];
+int team03_stabilityWeights[TEAM03_EVAL_PHASES];
+
+// Move picker stages, in the order moves are handed out
+#define TEAM03_PICK_TT 0
+#define TEAM03_PICK_CORNERS 1
+#define TEAM03_PICK_KILLERS 2
+#define TEAM03_PICK_REST 3
+#define TEAM03_PICK_LIST 4
+
+// Per-square direction rays (E, SW, S, SE, W, NE, N, NW), excluding the
+// square itself; the first four run towards higher bit indices
+uint64_t team03_rays[64][8];
+
+// Per-square masks of the (up to 8) adjacent squares; a move has to be
+// next to an opponent piece, which is far cheaper to check than flips
+uint64_t team03_neighbours[64];
+
+// Kernels picked by `team03_initKernels`; the scalar variants until then
+int (*team03_popcountKernel)(uint64_t) = team03_popcountScalar;
+uint64_t (*team03_legalMovesKernel)(board_t, int) = team03_getLegalMovesScalar;
+uint64_t (*team03_flipsKernel)(board_t, int8_t, int) = team03_computeFlipsScalar;
+int (*team03_mobilityKernel)(board_t, int) = team03_computeMobilityScalar;
+int (*team03_mobilityDiffKernel)(board_t, int) = team03_computeMobilityDiffScalar;
+int (*team03_patternSumKernel)(const int16_t *, const uint32_t *) = team03_sumPatternsScalar;
+
+// Line tables for the PEXT flip kernel. For each square: the row, column,
+// diagonal and anti-diagonal through it, and its index within each line
+// once extracted. For each index in an 8-cell line: the candidate
+// outflanking cells given the opponent's 6 inner cells, and the cells
+// flipped given the actual outflanking cells. ~5 KB total.
+uint64_t team03_lineMasks[64][4];
+uint8_t team03_linePos[64][4];
+uint8_t team03_outflank[8][64];
+uint8_t team03_flipped[8][256];
+
+// Every diagonal (SE/NW) and anti-diagonal (SW/NE) on the board, for
+// finding full lines in the stability check
+uint64_t team03_diagonals[2][15];
+
+// Zobrist keys: per color and square, the XOR of both colors per square
+// (for flips), and the key mixed in when white is to move
+uint64_t team03_zobrist[2][64];
+uint64_t team03_zobristFlip[64];
+uint64_t team03_zobristSide;
+uint64_t team03_zobristEndgame; // mixed into keys of exact endgame results
+
+// Transposition table bound types
+#define TEAM03_TT_EXACT 0
+#define TEAM03_TT_LOWER 1 // score is a lower bound (failed high)
+#define TEAM03_TT_UPPER 2 // score is an upper bound (failed low)
+
+// Transposition table; lives for the whole game so later moves can reuse
+// earlier searches. `team03_ttMemory` is the unaligned allocation.
+team03_ttBucket_t *team03_tt = NULL;
+void *team03_ttMemory = NULL;
+uint64_t team03_ttMask = 0; // # of buckets - 1
+uint8_t team03_ttAge = 0;
+
+// Search threads. Helper 0 is unused; the main thread is thread 0.
+// `team03_stop` tells helpers (and the main thread) to unwind.
+int team03_numThreads = 1;
+team03_helper_t team03_helpers[TEAM03_MAX_THREADS];
+int team03_stop = 0;
+int team03_parallel = TEAM03_PARALLEL;
+int team03_usePVS = TEAM03_USE_PVS;
+int team03_usePonder = TEAM03_PONDER;
+
+// The pondering thread; uses the helper struct for its root position.
+// It runs as thread id 0 on purpose: the main thread is idle while it
+// runs, so it shares (and warms) the main thread's killer, history and
+// stats slot. `team03_pondered` notes that it aged the table for our
+// next move, so `team03_getMove` doesn't age it a second time.
+team03_helper_t team03_ponder;
+int team03_pondered = 0;
+
+// Search timer: the deadline on the monotonic clock, the thread that
+// raises `team03_stop` when it passes, and each thread's node count since
+// it last checked the clock itself
+long long team03_deadline = TEAM03_NO_DEADLINE;
+int team03_timerCancel = 0, team03_timerRunning = 0;
+#ifdef TEAM03_IS_POSIX
+pthread_t team03_timerThread;
+#endif
+TEAM03_TLS unsigned team03_pollCount = 0;
+
+// Aspiration window statistics per depth, over the whole game
+team03_aspStats_t team03_aspStats[TEAM03_MAX_LAYERS + 1];
+
+// Move ordering state per thread: two killer moves per ply and a history
+// score per color and square. Plies are counted by empty squares, which
+// is the same for every node at a given ply (passes aside) and stays put
+// between iterations. Killers are bit indices, or -1 for none. The square
+// scores break ties between moves without much history: X and C squares
+// (next to an empty corner, usually) last, edges and the centre first.
+const int team03_squareScores[64] = {
+        0, -2, 2, 1, 1, 2, -2, 0,
+        -2, -3, -1, -1, -1, -1, -3, -2,
+        2, -1, 1, 0, 0, 1, -1, 2,
+        1, -1, 0, 0, 0, 0, -1, 1,
+        1, -1, 0, 0, 0, 0, -1, 1,
+        2, -1, 1, 0, 0, 1, -1, 2,
+        -2, -3, -1, -1, -1, -1, -3, -2,
+        0, -2, 2, 1, 1, 2, -2, 0
+};
+int8_t team03_killers[TEAM03_MAX_THREADS][64][2];
+int team03_history[TEAM03_MAX_THREADS][2][64];
+team03_orderStats_t team03_orderStats[TEAM03_MAX_THREADS];
+
+// Search statistics: node counters per thread, and the summary of our
+// last move's search. `team03_statsBase` and `team03_statsMark` are the
+// summed counters at the start of the move and the end of the last
+// iteration, since the counters themselves run over the whole game.
+TEAM03_ALIGN(64) team03_nodeStats_t team03_nodeStats[TEAM03_MAX_THREADS];
+team03_moveStats_t team03_moveStats;
+team03_nodeStats_t team03_statsBase, team03_statsMark;
+long long team03_statsStart = 0, team03_iterStart = 0;
+FILE *team03_statsOut = NULL;
+
+// YBWC state: a work-stealing deque of open split points per thread, and
+// each thread's id and innermost split point (for abort checks)
+team03_deque_t team03_deques[TEAM03_MAX_THREADS];
+TEAM03_TLS int team03_threadId = 0;
+TEAM03_TLS team03_split_t *team03_curSplit = NULL;
+
+// Each thread's pattern codes for the node it's searching (see
+// `team03_solveBoard`); NULL outside of a search
+TEAM03_TLS const team03_patterns_t *team03_curPatterns = NULL;
+
 
 /*
  **********************
@@ -86,13 +379,18 @@ struct timeval team03_startTime; // start time of the current move
  * @return the position we place a piece at.
  */
 position *team03Move(const enum piece board[][SIZE], enum piece mine, int secondsleft) {
-    // Translate stuff
+    // Build our tables (first move only) and translate stuff
+    team03_init();
+    team03_stopPonder();
     board_t state = team03_loadBoard(board);
     int color = (mine == WHITE);
     
     // Perform the move with our own state format
     pos_t pos = team03_getMove(state, color, secondsleft);
     
+    // Think about the opponent's reply on their time
+    if (team03_usePonder) team03_startPonder(team03_executeMove(state, pos, color), !color);
+    
     // Dynamically allocate the return position
     position *res = malloc(sizeof(position));
     res->x = pos.y, res->y = pos.x;
@@ -113,6 +411,7 @@ position *team03Move(const enum piece board[][SIZE], enum piece mine, int second
 pos_t team03_getMove(board_t state, int color, int time) {
     // Start the move clock and allocate time
     gettimeofday(&team03_startTime, 0);
+    team03_init();
     team03_maxTime = team03_allocateTime(state, color, time);
 
 #if TEAM03_DEBUG
@@ -120,8 +419,13 @@ pos_t team03_getMove(board_t state, int color, int time) {
     printf("We have " ANSI_CYAN "%d s" ANSI_RESET " left.\n", time);
 #endif
     
-    // Search for a move
+    // Search for a move, aging the table unless the ponder already did
+    if (!team03_pondered) team03_ttNewSearch();
+    team03_pondered = 0;
+    team03_ageHistory();
+    team03_startStats(state, color);
     pos_t res = team03_iterate(state, color);
+    team03_finishStats(res);
 
 #if TEAM03_DEBUG
     // Print how much time we took to pick a move, if debug is on
@@ -133,6 +437,91 @@ pos_t team03_getMove(board_t state, int color, int time) {
     return res;
 }
 
+/**
+ * Builds all of the lookup tables used by the bot. Safe to call more
+ * than once; only the first call does any work.
+ */
+void team03_init(void) {
+    static int initialized = 0;
+    if (initialized) return;
+    
+    team03_initRays();
+    team03_initLines();
+    team03_initKernels();
+    team03_initZobrist();
+    team03_initPatterns();
+    const char *weights = getenv("TEAM03_WEIGHTS");
+    if (!team03_loadWeights(weights ? weights : TEAM03_WEIGHTS_FILE) && weights)
+        fprintf(stderr, "team03: couldn't load weights from %s; using the defaults\n", weights);
+    memset(team03_killers, -1, sizeof(team03_killers));
+    
+    // Allocate the transposition table; its size can be set from outside
+    const char *hashMB = getenv("TEAM03_HASH_MB");
+    long megabytes = TEAM03_HASH_MB;
+    if (hashMB) {
+        char *end;
+        megabytes = strtol(hashMB, &end, 10);
+        if (end == hashMB || *end || megabytes <= 0) {
+            fprintf(stderr, "team03: bad TEAM03_HASH_MB \"%s\"; using %d MB\n", hashMB, TEAM03_HASH_MB);
+            megabytes = TEAM03_HASH_MB;
+        }
+        if (megabytes > TEAM03_HASH_MAX_MB) megabytes = TEAM03_HASH_MAX_MB;
+    }
+    team03_ttResize((size_t) megabytes);
+    
+    // Pick a thread count; helpers need pthreads, so Windows gets one
+#ifdef TEAM03_IS_POSIX
+    const char *threads = getenv("TEAM03_THREADS");
+    long count = TEAM03_THREADS;
+    if (threads) {
+        char *end;
+        count = strtol(threads, &end, 10);
+        if (end == threads || *end || count < 0) {
+            fprintf(stderr, "team03: bad TEAM03_THREADS \"%s\"; using %d\n", threads, TEAM03_THREADS);
+            count = TEAM03_THREADS;
+        }
+        if (count > TEAM03_MAX_THREADS) count = TEAM03_MAX_THREADS;
+    }
+    team03_numThreads = (int) count;
+    if (team03_numThreads <= 0) team03_numThreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (team03_numThreads > TEAM03_MAX_THREADS) team03_numThreads = TEAM03_MAX_THREADS;
+    if (team03_numThreads < 1) team03_numThreads = 1;
+#endif
+    const char *parallel = getenv("TEAM03_PARALLEL");
+    if (parallel) {
+        if (team03_equalsIgnoreCase(parallel, "ybwc")) team03_parallel = TEAM03_PARALLEL_YBWC;
+        else if (team03_equalsIgnoreCase(parallel, "lazy")) team03_parallel = TEAM03_PARALLEL_LAZY;
+        else fprintf(stderr, "team03: bad TEAM03_PARALLEL \"%s\"; using %s\n", parallel,
+                     team03_parallel == TEAM03_PARALLEL_YBWC ? "ybwc" : "lazy");
+    }
+    for (int i = 0; i < TEAM03_MAX_THREADS; i++) TEAM03_LOCK_INIT(&team03_deques[i].lock);
+    const char *pvs = getenv("TEAM03_PVS");
+    if (pvs) team03_usePVS = atoi(pvs);
+    const char *ponder = getenv("TEAM03_PONDER");
+    if (ponder) team03_usePonder = atoi(ponder);
+    const char *stats = getenv("TEAM03_STATS");
+    if (!stats) stats = TEAM03_STATS_FILE;
+    if (stats) team03_statsOut = strcmp(stats, "-") ? fopen(stats, "a") : stderr;
+    initialized = 1;
+}
+
+/**
+ * Compares two strings, ignoring ASCII case (for environment settings).
+ *
+ * @param a the first string
+ * @param b the second string
+ *
+ * @return whether the strings are equal up to case
+ */
+int team03_equalsIgnoreCase(const char *a, const char *b) {
+    for (; *a && *b; a++, b++) {
+        char x = (*a >= 'A' && *a <= 'Z') ? (char) (*a - 'A' + 'a') : *a;
+        char y = (*b >= 'A' && *b <= 'Z') ? (char) (*b - 'A' + 'a') : *b;
+        if (x != y) return 0;
+    }
+    return *a == *b;
+}
+
 
 /*
  **********************
@@ -199,18 +588,500 @@ float team03_computeParity(board_t state, int color) {
  * @return the number of valid moves that the color can take
  */
 int team03_computeMobility(board_t state, int color) {
-    // Count for number of valid moves
-    int res = 0;
+    return team03_mobilityKernel(state, color);
+}
+
+/**
+ * Scalar mobility kernel; counts the bits in the legal move mask.
+ *
+ * @param state the current board state
+ * @param color the color to consider moves for
+ *
+ * @return the number of valid moves that the color can take
+ */
+int team03_computeMobilityScalar(board_t state, int color) {
+    return team03_popcountScalar(team03_getLegalMovesScalar(state, color));
+}
+
+/**
+ * Computes the given color's mobility advantage: its number of valid
+ * moves less its opponent's.
+ *
+ * @param state the current board state
+ * @param color the color to consider moves for
+ *
+ * @return the difference in the number of valid moves
+ */
+int team03_computeMobilityDiff(board_t state, int color) {
+    return team03_mobilityDiffKernel(state, color);
+}
+
+/**
+ * Scalar mobility advantage kernel; one mobility count per side.
+ *
+ * @param state the current board state
+ * @param color the color to consider moves for
+ *
+ * @return the difference in the number of valid moves
+ */
+int team03_computeMobilityDiffScalar(board_t state, int color) {
+    return team03_mobilityKernel(state, color) - team03_mobilityKernel(state, !color);
+}
+
+/**
+ * Finds a lower bound on the given color's stable discs: ones that can
+ * never be flipped again. A disc is stable if, along each of the four
+ * lines through it, the line is full or one of its two neighbours is off
+ * the board or a stable disc of the same color. Starting from none, the
+ * rule is applied until nothing changes (corners go first, since they
+ * have no neighbours on any line).
+ *
+ * @param state the board state
+ * @param color the color to find stable discs for
+ *
+ * @return a mask of the color's stable discs
+ */
+uint64_t team03_getStable(board_t state, int color) {
+    uint64_t own = team03_getPieces(state, color), on = state.on;
+    
+    // Full rows and columns
+    uint64_t fullRows = 0, fullCols = on;
+    for (int y = 0; y < 8; y++)
+        if (((on >> (y * 8)) & 0xff) == 0xff) fullRows |= 0xffull << (y * 8);
+    fullCols &= fullCols >> 32, fullCols &= fullCols >> 16, fullCols &= fullCols >> 8;
+    fullCols = (fullCols & 0xff) * 0x0101010101010101ull;
+    
+    // Besides corners, a disc can only be stable on its own with a full
+    // row or column through it; without any, there's nothing to grow from
+    if (!(own & TEAM03_CORNERS) && !fullRows && !fullCols) return 0;
+    
+    // Full diagonals and anti-diagonals
+    uint64_t fullDiag = 0, fullAnti = 0;
+    for (int i = 0; i < 15; i++) {
+        if ((on & team03_diagonals[0][i]) == team03_diagonals[0][i]) fullDiag |= team03_diagonals[0][i];
+        if ((on & team03_diagonals[1][i]) == team03_diagonals[1][i]) fullAnti |= team03_diagonals[1][i];
+    }
+    
+    // Lines safe no matter what: full, or with a neighbour off the board
+    const uint64_t edgeCols = 0x8181818181818181ull, edgeRows = 0xff000000000000ffull;
+    fullRows |= edgeCols;
+    fullCols |= edgeRows;
+    fullDiag |= edgeCols | edgeRows;
+    fullAnti |= edgeCols | edgeRows;
+    
+    uint64_t stable = 0, prev;
+    do {
+        prev = stable;
+        uint64_t row = fullRows | ((stable >> 1) & TEAM03_NOT_H_FILE) | ((stable << 1) & TEAM03_NOT_A_FILE);
+        uint64_t col = fullCols | (stable >> 8) | (stable << 8);
+        uint64_t diag = fullDiag | ((stable >> 9) & TEAM03_NOT_H_FILE) | ((stable << 9) & TEAM03_NOT_A_FILE);
+        uint64_t anti = fullAnti | ((stable >> 7) & TEAM03_NOT_A_FILE) | ((stable << 7) & TEAM03_NOT_H_FILE);
+        stable = own & row & col & diag & anti;
+    } while (stable != prev);
+    return stable;
+}
+
+/**
+ * Counts a color's stable discs minus its opponent's, for the static
+ * evaluation. There are hardly ever any before a corner is taken, so the
+ * search for them is skipped until then.
+ *
+ * @param state the board state
+ * @param color the color to count for
+ *
+ * @return the difference in stable discs (a lower bound for each side)
+ */
+int team03_getStableDiff(board_t state, int color) {
+    if (!(state.on & TEAM03_CORNERS)) return 0;
+    return team03_popcount(team03_getStable(state, color)) - team03_popcount(team03_getStable(state, !color));
+}
+
+// Pattern gathers for `team03_gatherPatterns`: the top edge with B2 and
+// G2, the 2x5 and 3x3 top left corner blocks, and a diagonal given its
+// mask and first column (multiplying collects each column's bit into the
+// top byte, since the diagonal has one square per column)
+#define TEAM03_GATHER_EDGE(b) (uint16_t) (((b) & 0xff) | (((b) >> 1) & 0x100) | (((b) >> 5) & 0x200))
+#define TEAM03_GATHER_CORNER25(b) (uint16_t) (((b) & 0x1f) | (((b) >> 3) & 0x3e0))
+#define TEAM03_GATHER_CORNER33(b) (uint16_t) (((b) & 0x7) | (((b) >> 5) & 0x38) | (((b) >> 10) & 0x1c0))
+#define TEAM03_GATHER_DIAG(b, mask, col) (uint16_t) ((((b) & (mask)) * 0x0101010101010101ull) >> (56 + (col)))
+
+/**
+ * Gathers the squares of every pattern instance from a bitboard, as a
+ * binary number per instance with digit k of the pattern in bit k. The
+ * instances are read off the board's symmetric images, so each type's
+ * instances line up square for square.
+ *
+ * @param x the bitboard (one color's discs)
+ * @param out the gathered bits, per instance
+ */
+void team03_gatherPatterns(uint64_t x, uint16_t *out) {
+    // The eight images: t* are flipped about the diagonal after the other
+    // flips, but the same boards come from flipping t itself
+    uint64_t h = team03_mirrorHorizontal(x), v = team03_flipVertical(x), vh = team03_flipVertical(h);
+    uint64_t t = team03_flipDiagonal(x), th = team03_flipVertical(t);
+    uint64_t tv = team03_mirrorHorizontal(t), tvh = team03_flipVertical(tv);
+    
+    out[0] = TEAM03_GATHER_EDGE(x), out[1] = TEAM03_GATHER_EDGE(v);
+    out[2] = TEAM03_GATHER_EDGE(t), out[3] = TEAM03_GATHER_EDGE(th);
+    
+    out[4] = TEAM03_GATHER_CORNER25(x), out[5] = TEAM03_GATHER_CORNER25(h);
+    out[6] = TEAM03_GATHER_CORNER25(v), out[7] = TEAM03_GATHER_CORNER25(vh);
+    out[8] = TEAM03_GATHER_CORNER25(t), out[9] = TEAM03_GATHER_CORNER25(th);
+    out[10] = TEAM03_GATHER_CORNER25(tv), out[11] = TEAM03_GATHER_CORNER25(tvh);
+    
+    out[12] = TEAM03_GATHER_CORNER33(x), out[13] = TEAM03_GATHER_CORNER33(h);
+    out[14] = TEAM03_GATHER_CORNER33(v), out[15] = TEAM03_GATHER_CORNER33(vh);
+    
+    // Diagonals on the board and its mirror image (the anti-diagonals);
+    // the shorter ones come in pairs either side of the main diagonal
+    out[16] = TEAM03_GATHER_DIAG(x, 0x8040201008040201ull, 0);
+    out[17] = TEAM03_GATHER_DIAG(h, 0x8040201008040201ull, 0);
+    for (int i = 0; i < 2; i++) {
+        uint64_t b = i ? h : x;
+        out[18 + 2 * i] = TEAM03_GATHER_DIAG(b, 0x0080402010080402ull, 1);
+        out[19 + 2 * i] = TEAM03_GATHER_DIAG(b, 0x4020100804020100ull, 0);
+        out[22 + 2 * i] = TEAM03_GATHER_DIAG(b, 0x0000804020100804ull, 2);
+        out[23 + 2 * i] = TEAM03_GATHER_DIAG(b, 0x2010080402010000ull, 0);
+        out[26 + 2 * i] = TEAM03_GATHER_DIAG(b, 0x0000008040201008ull, 3);
+        out[27 + 2 * i] = TEAM03_GATHER_DIAG(b, 0x1008040201000000ull, 0);
+        out[30 + 2 * i] = TEAM03_GATHER_DIAG(b, 0x0000000080402010ull, 4);
+        out[31 + 2 * i] = TEAM03_GATHER_DIAG(b, 0x0804020100000000ull, 0);
+    }
+}
+
+/**
+ * Computes the pattern codes of a board from scratch.
+ *
+ * @param out the codes to fill in (as table indices)
+ * @param state the board state
+ */
+void team03_computePatterns(team03_patterns_t *out, board_t state) {
+    uint16_t black[TEAM03_PATTERNS], white[TEAM03_PATTERNS];
+    team03_gatherPatterns(state.on & ~state.color, black);
+    team03_gatherPatterns(state.color, white);
+    
+    out->on = state.on, out->color = state.color;
+    for (int i = 0; i < TEAM03_PATTERNS; i++)
+        out->indices[i] = (uint32_t) (team03_patternOffsets[i] + team03_base3[black[i]] + 2 * team03_base3[white[i]]);
+}
+
+/**
+ * Updates pattern codes to a board with the same discs and more, like a
+ * child of the board they're for: only the digits of the squares that
+ * were filled or flipped change. Otherwise (or with no codes to start
+ * from) they're computed from scratch.
+ *
+ * @param out the codes to fill in
+ * @param from the codes to start from, or NULL
+ * @param state the board state to update them to
+ */
+void team03_updatePatterns(team03_patterns_t *out, const team03_patterns_t *from, board_t state) {
+    if (!from || (from->on & ~state.on)) {
+        team03_computePatterns(out, state);
+        return;
+    }
+    *out = *from;
+    out->on = state.on, out->color = state.color;
     
-    // Loop over all cell positions
-    pos_t pos = team03_makePos(0, 0);
-    for (; pos.y < 8; pos.y++) {
-        for (pos.x = 0; pos.x < 8; pos.x++) {
-            // Update our valid move count if we found one
-            res += team03_isValidMove(state, pos, color);
+    // Filled squares go from 0 to 1 (black) or 2 (white); flipped ones
+    // between 1 and 2
+    for (uint64_t placed = state.on & ~from->on; placed; placed &= placed - 1) {
+        int sq = team03_bitScan(placed), digit = 1 + (int) ((state.color >> sq) & 1);
+        for (int k = 0; k < team03_squarePatternCount[sq]; k++)
+            out->indices[team03_squarePatterns[sq][k]] += (uint32_t) (digit * team03_squarePowers[sq][k]);
+    }
+    for (uint64_t flips = (state.color ^ from->color) & from->on; flips; flips &= flips - 1) {
+        int sq = team03_bitScan(flips), toWhite = (int) ((state.color >> sq) & 1);
+        for (int k = 0; k < team03_squarePatternCount[sq]; k++) {
+            uint32_t *index = &out->indices[team03_squarePatterns[sq][k]];
+            *index = toWhite ? *index + team03_squarePowers[sq][k] : *index - team03_squarePowers[sq][k];
         }
     }
-    return res;
+}
+
+/**
+ * Evaluates the board with the pattern tables for the given phase. Uses
+ * the current node's codes if they're for this board, and computes them
+ * otherwise.
+ *
+ * @param state the board state
+ * @param phase the board's phase (from its disc count)
+ *
+ * @return the score from black's point of view
+ */
+int team03_evaluatePatterns(board_t state, int phase) {
+    team03_patterns_t computed;
+    const team03_patterns_t *patterns = team03_curPatterns;
+    if (!patterns || patterns->on != state.on || patterns->color != state.color) {
+        team03_computePatterns(&computed, state);
+        patterns = &computed;
+    }
+    return team03_patternSumKernel(team03_evalTable[phase], patterns->indices);
+}
+
+/**
+ * Scalar pattern sum kernel: one load per instance, into two running
+ * sums so the loads don't wait on each other's adds.
+ *
+ * @param table the phase's pattern tables
+ * @param indices each instance's index into the tables
+ *
+ * @return the sum of the instances' weights
+ */
+int team03_sumPatternsScalar(const int16_t *table, const uint32_t *indices) {
+    int sum0 = 0, sum1 = 0;
+    for (int i = 0; i < (TEAM03_PATTERNS & ~1); i += 2) {
+        sum0 += table[indices[i]];
+        sum1 += table[indices[i + 1]];
+    }
+    if (TEAM03_PATTERNS & 1) sum0 += table[indices[TEAM03_PATTERNS - 1]];
+    return sum0 + sum1;
+}
+
+#ifdef TEAM03_X86_KERNELS
+/**
+ * AVX2 pattern sum kernel: gathers 8 instances' weights at a time, as
+ * 32-bit loads at the weights' addresses (hence the tables' padding);
+ * a multiply-add by (1, 0) keeps each load's low half, sign-extended.
+ *
+ * @param table the phase's pattern tables
+ * @param indices each instance's index into the tables
+ *
+ * @return the sum of the instances' weights
+ */
+TEAM03_TARGET("avx2")
+int team03_sumPatternsAVX2(const int16_t *table, const uint32_t *indices) {
+    const __m256i low = _mm256_set1_epi32(1);
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < (TEAM03_PATTERNS & ~7); i += 8) {
+        __m256i index = _mm256_loadu_si256((const __m256i *) (indices + i));
+        __m256i words = _mm256_i32gather_epi32((const int *) table, index, 2);
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(words, low));
+    }
+    
+    // Add up the lanes, plus the instances left over from the gathers
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4e));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xb1));
+    int total = _mm_cvtsi128_si32(half);
+    for (int i = TEAM03_PATTERNS & ~7; i < TEAM03_PATTERNS; i++) total += table[indices[i]];
+    return total;
+}
+#endif // TEAM03_X86_KERNELS
+
+/**
+ * Builds the pattern tables: each instance's squares and table offset,
+ * each square's instances, the base-3 conversions and phases, and the
+ * default weights (see `team03_defaultWeight`).
+ */
+void team03_initPatterns(void) {
+    for (int i = 0; i < 1024; i++)
+        for (int k = 9; k >= 0; k--) team03_base3[i] = (uint16_t) (team03_base3[i] * 3 + ((i >> k) & 1));
+    for (int discs = 0; discs <= 64; discs++) {
+        int phase = (discs - 4) * TEAM03_EVAL_PHASES / 61;
+        team03_evalPhase[discs] = phase < 0 ? 0 : phase >= TEAM03_EVAL_PHASES ? TEAM03_EVAL_PHASES - 1 : phase;
+    }
+    
+    // Find each instance's squares, and the instances covering each
+    // square, by gathering every square on its own
+    uint16_t bits[TEAM03_PATTERNS];
+    int coverage[64] = { 0 };
+    for (int sq = 0; sq < 64; sq++) {
+        team03_gatherPatterns(1ull << sq, bits);
+        for (int i = 0; i < TEAM03_PATTERNS; i++) {
+            if (!bits[i]) continue;
+            assert(coverage[sq] < 8);
+            int digit = team03_bitScan(bits[i]), power = 1;
+            for (int k = 0; k < digit; k++) power *= 3;
+            team03_patternSquares[i][digit] = (int8_t) sq;
+            team03_squarePatterns[sq][coverage[sq]] = (int8_t) i;
+            team03_squarePowers[sq][coverage[sq]++] = (uint16_t) power;
+        }
+    }
+    
+    for (int sq = 0; sq < 64; sq++) team03_squarePatternCount[sq] = coverage[sq];
+    
+    // Lay the types' tables out end to end
+    int offsets[TEAM03_PATTERN_TYPES], size = 0;
+    for (int type = 0; type < TEAM03_PATTERN_TYPES; type++) {
+        offsets[type] = size;
+        int codes = 1;
+        for (int k = 0; k < team03_patternSizes[type]; k++) codes *= 3;
+        size += codes;
+    }
+    assert(size == TEAM03_PATTERN_TABLE_SIZE);
+    for (int i = 0; i < TEAM03_PATTERNS; i++) team03_patternOffsets[i] = offsets[team03_patternTypes[i]];
+    
+    // Fill in the weights from each type's first instance
+    for (int i = 0; i < TEAM03_PATTERNS; i++) {
+        int type = team03_patternTypes[i];
+        if (i && team03_patternTypes[i - 1] == type) continue;
+        int codes = (type + 1 < TEAM03_PATTERN_TYPES ? offsets[type + 1] : size) - offsets[type];
+        for (int phase = 0; phase < TEAM03_EVAL_PHASES; phase++)
+            for (int code = 0; code < codes; code++)
+                team03_evalTable[phase][offsets[type] + code] = (int16_t) team03_defaultWeight(i, phase, code, coverage);
+    }
+    
+    for (int phase = 0; phase < TEAM03_EVAL_PHASES; phase++) {
+        team03_mobilityWeights[phase] = TEAM03_MOBILITY_WEIGHT;
+        team03_parityWeights[phase] = TEAM03_PARITY_WEIGHT;
+        team03_stabilityWeights[phase] = TEAM03_STABLE_WEIGHT;
+    }
+}
+
+/**
+ * Scores a pattern configuration by hand, for want of trained weights:
+ * square values and a disc count term shared out over the instances
+ * covering each square, plus, for edges, the X and C squares next to an
+ * empty corner and discs anchored to an occupied one.
+ *
+ * @param pattern the pattern instance whose squares to use
+ * @param phase the game phase
+ * @param code the base-3 code of the configuration
+ * @param coverage the number of instances covering each square
+ *
+ * @return the weight, from black's point of view
+ */
+int team03_defaultWeight(int pattern, int phase, int code, const int *coverage) {
+    // Square values by distance from the nearest edges; X and C squares
+    // only count next to an empty corner, below
+    static const int squareValues[4][4] = {
+            { 40, 0, 8, 4 },
+            { 0, 0, -3, -3 },
+            { 8, -3, 1, 0 },
+            { 4, -3, 0, 0 }
+    };
+    static const int discValues[4] = { -2, 0, 3, 8 };
+    int discValue = discValues[phase * 4 / TEAM03_EVAL_PHASES];
+    
+    int size = team03_patternSizes[team03_patternTypes[pattern]], discs[10];
+    double score = 0;
+    for (int k = 0; k < size; k++, code /= 3) {
+        discs[k] = (code % 3 == 1) ? 1 : (code % 3 == 2) ? -1 : 0;
+        int sq = team03_patternSquares[pattern][k], y = sq / 8, x = sq % 8;
+        int dy = (y < 4) ? y : 7 - y, dx = (x < 4) ? x : 7 - x;
+        score += (double) discs[k] * (squareValues[dy][dx] + discValue) / coverage[sq];
+    }
+    if (team03_patternTypes[pattern] != TEAM03_PATTERN_EDGE) return (int) (score + (score < 0 ? -0.5 : 0.5));
+    
+    // Each end of the edge: digits 0/7 are the corners, 1/6 the C squares
+    // and 8/9 the X squares (each X square is on two edges, so half each)
+    for (int end = 0; end < 2; end++) {
+        int corner = end ? 7 : 0, step = end ? -1 : 1;
+        if (!discs[corner]) {
+            score -= 12 * discs[8 + end] + 12 * discs[corner + step];
+            continue;
+        }
+        for (int k = corner + step; k != corner + 8 * step && discs[k] == discs[corner]; k += step)
+            score += 6 * discs[k];
+    }
+    return (int) (score + (score < 0 ? -0.5 : 0.5));
+}
+
+/**
+ * Reads or writes one little-endian int32 of a weights file.
+ *
+ * @param file the weights file
+ * @param value the value to write, or where to read it to
+ * @param write 1 to write, 0 to read
+ *
+ * @return 1 on success, 0 on failure
+ */
+int team03_weightsInt(FILE *file, int *value, int write) {
+    unsigned char bytes[4];
+    if (write) {
+        for (int k = 0; k < 4; k++) bytes[k] = (unsigned char) ((unsigned int) *value >> (8 * k));
+        return fwrite(bytes, 4, 1, file) == 1;
+    }
+    if (fread(bytes, 4, 1, file) != 1) return 0;
+    *value = (int) ((unsigned int) bytes[0] | (unsigned int) bytes[1] << 8
+                    | (unsigned int) bytes[2] << 16 | (unsigned int) bytes[3] << 24);
+    return 1;
+}
+
+/**
+ * Clamps a pattern weight to what the tables can hold.
+ *
+ * @param weight the weight
+ *
+ * @return the weight, clamped to +/- 32767
+ */
+int16_t team03_clampWeight(int weight) {
+    return (int16_t) (weight < -32767 ? -32767 : weight > 32767 ? 32767 : weight);
+}
+
+/**
+ * Loads evaluation weights (pattern tables, mobility, parity and
+ * stability) from a file written by `team03_saveWeights`. The current
+ * weights are kept unless the whole file is read and matches our layout;
+ * pattern weights are clamped to fit the tables. Version 1 files, from
+ * before the stability weights, keep the current ones.
+ *
+ * @param path the weights file
+ *
+ * @return 1 if the weights were loaded, 0 otherwise
+ */
+int team03_loadWeights(const char *path) {
+    FILE *file = path ? fopen(path, "rb") : NULL;
+    if (!file) return 0;
+    
+    // Check the header against our layout before touching anything
+    char magic[4];
+    int version, phases, size, ok = fread(magic, 4, 1, file) == 1 && !memcmp(magic, TEAM03_WEIGHTS_MAGIC, 4)
+                                    && team03_weightsInt(file, &version, 0)
+                                    && version >= 1 && version <= TEAM03_WEIGHTS_VERSION
+                                    && team03_weightsInt(file, &phases, 0) && phases == TEAM03_EVAL_PHASES
+                                    && team03_weightsInt(file, &size, 0) && size == TEAM03_PATTERN_TABLE_SIZE;
+    
+    // Read into a scratch copy, since the file might be cut short
+    int terms = (version >= 2) ? 3 : 2; // weights by phase before the tables
+    int count = (terms + TEAM03_PATTERN_TABLE_SIZE) * TEAM03_EVAL_PHASES;
+    int *weights = ok ? malloc(sizeof(int) * count) : NULL;
+    for (int i = 0; weights && ok && i < count; i++) ok = team03_weightsInt(file, &weights[i], 0);
+    fclose(file);
+    if (!weights || !ok) {
+        free(weights);
+        return 0;
+    }
+    
+    memcpy(team03_mobilityWeights, weights, sizeof(team03_mobilityWeights));
+    memcpy(team03_parityWeights, weights + TEAM03_EVAL_PHASES, sizeof(team03_parityWeights));
+    if (terms > 2) memcpy(team03_stabilityWeights, weights + 2 * TEAM03_EVAL_PHASES, sizeof(team03_stabilityWeights));
+    for (int phase = 0; phase < TEAM03_EVAL_PHASES; phase++)
+        for (int i = 0; i < TEAM03_PATTERN_TABLE_SIZE; i++)
+            team03_evalTable[phase][i] = team03_clampWeight(weights[terms * TEAM03_EVAL_PHASES + phase * TEAM03_PATTERN_TABLE_SIZE + i]);
+    free(weights);
+    return 1;
+}
+
+/**
+ * Writes the current evaluation weights to a file, for
+ * `team03_loadWeights`.
+ *
+ * @param path the weights file
+ *
+ * @return 1 on success, 0 on failure
+ */
+int team03_saveWeights(const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (!file) return 0;
+    
+    int version = TEAM03_WEIGHTS_VERSION, phases = TEAM03_EVAL_PHASES, size = TEAM03_PATTERN_TABLE_SIZE;
+    int ok = fwrite(TEAM03_WEIGHTS_MAGIC, 4, 1, file) == 1 && team03_weightsInt(file, &version, 1)
+             && team03_weightsInt(file, &phases, 1) && team03_weightsInt(file, &size, 1);
+    for (int phase = 0; ok && phase < TEAM03_EVAL_PHASES; phase++)
+        ok = team03_weightsInt(file, &team03_mobilityWeights[phase], 1);
+    for (int phase = 0; ok && phase < TEAM03_EVAL_PHASES; phase++)
+        ok = team03_weightsInt(file, &team03_parityWeights[phase], 1);
+    for (int phase = 0; ok && phase < TEAM03_EVAL_PHASES; phase++)
+        ok = team03_weightsInt(file, &team03_stabilityWeights[phase], 1);
+    for (int phase = 0; ok && phase < TEAM03_EVAL_PHASES; phase++) {
+        for (int i = 0; ok && i < TEAM03_PATTERN_TABLE_SIZE; i++) {
+            int weight = team03_evalTable[phase][i];
+            ok = team03_weightsInt(file, &weight, 1);
+        }
+    }
+    return (fclose(file) == 0) && ok;
 }
 
 /**
@@ -223,42 +1094,18 @@ int team03_computeMobility(board_t state, int color) {
  * @return a relative score for the current board state
  */
 int team03_evaluateStatic(board_t state, int color) {
-    // Calculate an overall mobility score
-    int score = team03_computeMobility(state, color)
-                - team03_computeMobility(state, !color);
-    
-    // Add parity score
-//    int parityScore = team03_computeParity(state, color) * 2;
-//    score += parityScore;
-    
-    // Weight the corners
-    const pos_t corners[4] = {
-            {0, 0},
-            {0, 7},
-            {7, 7},
-            {7, 0}
-    };
+    // Pattern tables, from color's point of view
+    int discs = team03_popcount(state.on), phase = team03_evalPhase[discs];
+    int score = team03_evaluatePatterns(state, phase);
+    if (color) score = 0 - score;
     
-    // Corner weight starts at 4; goes up by 4 every 8 turns
-    int cornerWeight = 4 + (team03_getTurnNum(state, color) / 8) * 4;
-    for (int i = 0; i < 4; i++) {
-        int piece = team03_getPiece(state, corners[i]);
-        if (piece == color) score += cornerWeight;
-        if (piece == !color) score -= cornerWeight;
-    }
-    /*
-    const pos_t adjCorners[12] = {{0, 1}, {1, 1}, {1, 0}, {0, 6}, {1, 6}, {1, 7}, {7, 6}, {6, 6}, {6, 7}, {7, 1}, {6, 1}, {6, 0}};
-    for (int i = 0; i < 12; i++) {
-        pos_t corn;
-        if (adjCorners[i].x <= 1) corn.x = 0;
-        else corn.x = 7;
-        if (adjCorners[i].y <= 1) corn.y = 0;
-        else corn.y = 7;
-        if (team03_getPiece(state, adjCorners[i]) == color &&
-            team03_getPiece(state, corn) != color) score -= 3;
-    }
-    */
+    // Plus mobility and parity, which the tables can't see; with an odd
+    // number of empties, the side to move gets the last one
+    score += team03_mobilityWeights[phase] * team03_computeMobilityDiff(state, color);
+    score += team03_parityWeights[phase] * ((discs & 1) ? 1 : -1);
     
+    // And stable discs, which the tables only see a line at a time
+    if (team03_stabilityWeights[phase]) score += team03_stabilityWeights[phase] * team03_getStableDiff(state, color);
     return score;
 }
 
@@ -272,6 +1119,10 @@ int team03_evaluateStatic(board_t state, int color) {
 /**
  * Iteratively deepens the search tree, evaluating at higher and
  * higher depths until we've used as much time as we want.
+ * <br/><br/>
+ * If we have more than one thread, the helpers run the same search
+ * (Lazy SMP) and share what they find through the transposition table;
+ * only this thread's result is used.
  *
  * @param state the current board state
  * @param color our color
@@ -285,6 +1136,16 @@ pos_t team03_iterate(board_t state, int color) {
     
     // If there's only one valid move, don't bother traversing
     if (num == 1) return moveList[0].pos;
+    
+    // Arm the deadline for the rest of this move
+    team03_startTimer();
+    
+    // Close enough to the end to solve the game outright
+    if (64 - team03_popcount(state.on) <= TEAM03_WLD_EMPTIES) {
+        pos_t pos = team03_iterateEndgame(state, color, moveList, num);
+        team03_stopTimer();
+        return pos;
+    }
 
 #if TEAM03_DEBUG
     // Print our status if debugging is on
@@ -300,9 +1161,12 @@ pos_t team03_iterate(board_t state, int color) {
     // If we don't have any moves, we shouldn't have gotten a move at all
     assert(num != 0 && "Our turn but no moves available!");
     
-    // Track our overall best move & position to return
-    pos_t bestPos = moveList[0].pos;
-    pos_t retPos = bestPos;
+    // Track our overall best position to return, and each depth's score
+    pos_t retPos = moveList[0].pos;
+    int scores[TEAM03_MAX_LAYERS + 1];
+    
+    // Start the helper threads (if any) on the same position
+    team03_startHelpers(state, color, moveList, num, 0);
     
     // Iteratively deepen the search
     for (int layers = 1; layers <= team03_maxLayers; layers++) {
@@ -321,96 +1185,229 @@ pos_t team03_iterate(board_t state, int color) {
         printf(ANSI_CYAN " ^\n" ANSI_RESET);
 #endif
         
-        // Track our best move and alpha/beta for this depth
-        int best = -1e9, alpha = -1e9, beta = 1e9;
-        bestPos = team03_makePos(-1, -1);
+        // Search every move at this depth, in a window around the score
+        // from two layers up (scores swing with whose move the leaves are)
+        int center = (layers > 2) ? scores[layers - 2] : 0;
+        pos_t bestPos = team03_aspirate(state, color, moveList, num, layers, center, &retPos);
+        team03_recordIteration("midgame", layers, bestPos.x != -2);
         
-        // Iterate through valid moves for this position
-        for (int i = 0; i < num; i++) {
-            // DLS on the current move
-            solvePair_t pair = moveList[i];
-            solvePair_t pair2 = team03_solveBoard(
-                    team03_executeMove(state, pair.pos, color),
-                    color ^ 1, layers - 1, -beta, -alpha);
-            
-            // If we ran out of time, return our current best position
-            if (pair2.pos.x == -2) {
+        // If we ran out of time, keep the best position we have
+        if (bestPos.x == -2) {
 #if TEAM03_DEBUG
-                // Print how much time we've taken
-                long long taken = team03_timeSinceMs(team03_startTime);
-                printf("\rTimeout at depth " ANSI_CYAN "%d" ANSI_RESET
-                       " after " ANSI_RED "%lli ms\n" ANSI_RESET,
-                       layers, taken);
+            // Print how much time we've taken
+            long long taken = team03_timeSinceMs(team03_startTime);
+            printf("\rTimeout at depth " ANSI_CYAN "%d" ANSI_RESET
+                   " after " ANSI_RED "%lli ms\n" ANSI_RESET,
+                   layers, taken);
 #endif
-                return retPos;
-            }
-            
-            // Update the move's score with the opponent's best move
-            int score = 0 - pair2.score;
-            moveList[i].score = score;
-            
-            // Update our current best move
-            if (score > best) {
-                best = score;
-                bestPos = pair.pos;
-            }
-            
-            // Pruning or something
-            if (score > alpha) alpha = score;
-            if (alpha >= beta) {
-                best = alpha;
-                break;
-            }
+            break;
         }
         
-        // Sort our move list on the updated scores
-        team03_sort(moveList, 0, num - 1);
-        
         // Update return pos to the best move from this depth
         retPos = bestPos;
+        scores[layers] = moveList[0].score;
     }
     
-    // Return the best move we found
+    // Stop the helpers and return the best move we found
+    team03_stopHelpers();
+    team03_stopTimer();
+
+#if TEAM03_DEBUG
+    // Print how often each depth had to be re-searched so far this game
+    printf("Aspiration re-searches (fail low/high per search):");
+    for (int i = TEAM03_ASPIRATION_MIN_LAYER; i <= TEAM03_MAX_LAYERS; i++) {
+        team03_aspStats_t *stats = &team03_aspStats[i];
+        if (!stats->searches) continue;
+        printf(" %d:" ANSI_CYAN "%lld/%lld/%lld" ANSI_RESET, i,
+               stats->failLow, stats->failHigh, stats->searches);
+    }
+    printf("\nFirst-move cutoffs: " ANSI_CYAN "%.1f%%\n" ANSI_RESET,
+           100.0 * team03_firstCutoffRate());
+#endif
     return retPos;
 }
 
 /**
- * Finds the best move by searching up to the given depth. If we
- * use all of the allotted time (> team03_maxTime ms), returns a
- * pair with position (-2, -2).
+ * Searches the root to the given depth with an aspiration window around
+ * the given score. On a fail low or high, the failing side of the window
+ * is widened by doubling its margin, until the score lands inside it or
+ * the window is full.
+ * <br/><br/>
+ * If a fail-high move is found, it's already better than anything from
+ * the last depth, so `retPos` is updated with it straight away in case
+ * the re-search runs out of time.
  *
  * @param state the current board state
- * @param color the current color being considered
- * @param layer the number of layers to search through
- * @param alpha the alpha
- * @param beta the beta
+ * @param color our color
+ * @param moveList the root moves, best first
+ * @param num the number of root moves
+ * @param layers the depth to search to
+ * @param center the expected score (from an earlier depth)
+ * @param retPos the best move so far; updated on fail highs
  *
- * @return the best move
+ * @return the best move at this depth, or (-2, -2) if we ran out of time
  */
-solvePair_t team03_solveBoard(board_t state, int color, int layer, int alpha, int beta) {
-    // Check for a timeout
-    long long taken = team03_timeSinceMs(team03_startTime);
-    if (taken >= team03_maxTime) {
-        solvePair_t pair = team03_makeSolvePair(team03_makePos(-2, -2), 0);
+pos_t team03_aspirate(board_t state, int color, solvePair_t *moveList, int num, int layers,
+                      int center, pos_t *retPos) {
+    // Shallow depths are cheap and their scores jump around; search them whole
+    if (layers < TEAM03_ASPIRATION_MIN_LAYER)
+        return team03_searchRoot(state, color, moveList, num, layers, -1e9, 1e9);
+    
+    team03_aspStats_t *stats = &team03_aspStats[layers];
+    int lower = TEAM03_ASPIRATION_WINDOW, upper = TEAM03_ASPIRATION_WINDOW;
+    
+    while (1) {
+        // Past the max margin, give up on that side of the window
+        int alpha = (lower > TEAM03_ASPIRATION_MAX_WINDOW) ? -1e9 : center - lower;
+        int beta = (upper > TEAM03_ASPIRATION_MAX_WINDOW) ? 1e9 : center + upper;
+        
+        stats->searches++;
+        pos_t bestPos = team03_searchRoot(state, color, moveList, num, layers, alpha, beta);
+        if (bestPos.x == -2) return bestPos;
+        
+        // Widen whichever side we failed on and try again
+        int score = moveList[0].score;
+        if (score <= alpha && alpha > -1e9) {
+            stats->failLow++;
+            lower *= 2;
+        } else if (score >= beta && beta < 1e9) {
+            stats->failHigh++;
+            upper *= 2;
+            *retPos = bestPos;
+        } else return bestPos;
+    }
+}
+
+/**
+ * Searches every root move to the given depth, updating each move's score
+ * with the result and re-sorting the move list on the updated scores.
+ *
+ * @param state the current board state
+ * @param color our color
+ * @param moveList the root moves, best first
+ * @param num the number of root moves
+ * @param layers the depth to search to
+ * @param alpha the root's alpha
+ * @param beta the root's beta
+ *
+ * @return the best move at this depth, or (-2, -2) if we ran out of time
+ */
+pos_t team03_searchRoot(board_t state, int color, solvePair_t *moveList, int num, int layers,
+                        int alpha, int beta) {
+    // Track our best move for this depth
+    int best = -1e9;
+    pos_t bestPos = team03_makePos(-1, -1);
+    
+    // Iterate through valid moves for this position
+    for (int i = 0; i < num; i++) {
+        // DLS on the current move
+        solvePair_t pair = moveList[i];
+        solvePair_t pair2 = team03_searchChild(
+                team03_executeMove(state, pair.pos, color),
+                color ^ 1, layers - 1, alpha, beta, i == 0);
+        
+        // If we ran out of time, bail out
+        if (pair2.pos.x == -2) return pair2.pos;
+        
+        // Update the move's score with the opponent's best move
+        int score = 0 - pair2.score;
+        moveList[i].score = score;
+        
+        // Update our current best move
+        if (score > best) {
+            best = score;
+            bestPos = pair.pos;
+        }
+        
+        // Pruning or something
+        if (score > alpha) alpha = score;
+        if (alpha >= beta) break;
+    }
+    
+    // Sort our move list on the updated scores
+    team03_sort(moveList, 0, num - 1);
+    return bestPos;
+}
+
+/**
+ * Finds the best move by searching up to the given depth. If we
+ * use all of the allotted time (> team03_maxTime ms), returns a
+ * pair with position (-2, -2).
+ * <br/><br/>
+ * The node's pattern codes live in this frame, updated from the
+ * parent's, for the static evaluation at the leaves.
+ *
+ * @param state the current board state
+ * @param color the current color being considered
+ * @param layer the number of layers to search through
+ * @param alpha the alpha
+ * @param beta the beta
+ *
+ * @return the best move
+ */
+solvePair_t team03_solveBoard(board_t state, int color, int layer, int alpha, int beta) {
+    team03_patterns_t node;
+    const team03_patterns_t *parent = team03_curPatterns;
+    team03_updatePatterns(&node, parent, state);
+    
+    team03_curPatterns = &node;
+    solvePair_t res = team03_solveNode(state, color, layer, alpha, beta);
+    team03_curPatterns = parent;
+    return res;
+}
+
+/**
+ * Searches a node for `team03_solveBoard`, once its pattern codes are
+ * set up.
+ *
+ * @param state the current board state
+ * @param color the current color being considered
+ * @param layer the number of layers to search through
+ * @param alpha the alpha
+ * @param beta the beta
+ *
+ * @return the best move, or position (-2, -2) if we ran out of time
+ */
+solvePair_t team03_solveNode(board_t state, int color, int layer, int alpha, int beta) {
+    // Check for a timeout (or the main thread being done, for helpers, or
+    // a cutoff at a split point above us)
+    if (team03_timeUp() || team03_splitAborted(team03_curSplit)) {
+        solvePair_t pair = team03_makeSolvePair(team03_makePos(-2, -2), 0);
         return pair;
     }
+    team03_nodeStats_t *counts = &team03_nodeStats[team03_threadId];
+    counts->nodes++;
     
     // If we're at a leaf, return our score
     if (layer == 0) {
+        counts->leaves++;
         int score = team03_evaluateStatic(state, color);
         pos_t pos = team03_makePos(-1, -1);
         return team03_makeSolvePair(pos, score);
     }
     
-    // Find valid moves (without static eval)
-    solvePair_t pairs[64];
-    int num = team03_getMoves(state, color, pairs, 0);
+    // Check the transposition table; we can return early if this
+    // position was already searched deep enough with a usable bound
+    uint64_t key = team03_hashKey(state, color);
+    int alphaOrig = alpha, ttMove = -1;
+    team03_ttData_t tt;
+    if (team03_ttProbe(key, &tt)) {
+        ttMove = tt.move;
+        if (tt.depth >= layer && (tt.bound == TEAM03_TT_EXACT
+                                  || (tt.bound == TEAM03_TT_LOWER && tt.score >= beta)
+                                  || (tt.bound == TEAM03_TT_UPPER && tt.score <= alpha))) {
+            pos_t pos = ttMove < 0 ? team03_makePos(-1, -1) : team03_getPosByIndex(ttMove);
+            return team03_makeSolvePair(pos, tt.score);
+        }
+    }
+    
+    // Find valid moves
+    uint64_t moves = team03_getLegalMoves(state, color);
     
     // Check if there aren't any moves available for the current color
-    if (num == 0) {
+    if (!moves) {
         // Check if the opponent can move
-        num = team03_getMoves(state, !color, pairs, 0);
-        if (num) {
+        if (team03_getLegalMoves(state, !color)) {
             // If so, do the opponent move
             solvePair_t ret = team03_solveBoard(state, color ^ 1, layer - 1, -beta, -alpha);
             ret.score = 0 - ret.score;
@@ -429,15 +1426,28 @@ solvePair_t team03_solveBoard(board_t state, int color, int layer, int alpha, in
         return ret;
     }
     
+    // Hand out moves lazily, best guess first, since a cutoff often
+    // means most of them never get searched. Deep nodes the table knows
+    // nothing about can afford to rank them properly instead.
+    team03_picker_t picker;
+    solvePair_t ranked[64];
+    if (layer >= TEAM03_RANK_MIN_LAYER && ttMove < 0 && moves & (moves - 1)) {
+        int num = team03_rankMoves(state, color, ranked, TEAM03_RANK_LAYERS);
+        if (num < 0) return team03_makeSolvePair(team03_makePos(-2, -2), 0);
+        team03_initPickerList(&picker, ranked, num);
+    } else team03_initPicker(&picker, state, color, moves, ttMove);
+    
     // Track our current best move
     int best = -1e9;
     pos_t bestPos = team03_makePos(-1, -1);
     
     // Loop over valid moves for the current color
-    for (int i = 0; i < num; i++) {
+    for (int i = 0, ind; (ind = team03_nextMove(&picker)) >= 0; i++) {
+        pos_t pos = team03_getPosByIndex(ind);
+        
         // Execute the current move and figure out the opponent's best move
-        board_t cur = team03_executeMove(state, pairs[i].pos, color);
-        solvePair_t oppSolve = team03_solveBoard(cur, !color, layer - 1, -beta, -alpha);
+        board_t cur = team03_executeMove(state, pos, color);
+        solvePair_t oppSolve = team03_searchChild(cur, !color, layer - 1, alpha, beta, i == 0);
         
         // If we ran out of time, return the opponent's move
         if (oppSolve.pos.x == -2) return oppSolve;
@@ -446,57 +1456,1665 @@ solvePair_t team03_solveBoard(board_t state, int color, int layer, int alpha, in
         int score = 0 - oppSolve.score;
         if (score > best) {
             best = score;
-            bestPos = pairs[i].pos;
+            bestPos = pos;
         }
         
         // Pruning or something
         if (score > alpha) alpha = score;
         if (alpha >= beta) {
+            team03_recordCutoff(state, color, layer, bestPos, i);
+            team03_ttStore(key, alpha, layer, TEAM03_TT_LOWER, team03_getIndexByPos(bestPos));
             solvePair_t pair = team03_makeSolvePair(bestPos, alpha);
             return pair;
         }
+        
+        // Young Brothers Wait: once the eldest child is searched, the
+        // rest of the moves can be shared with idle threads (in order)
+        if (i == 0 && picker.moves && team03_canSplit(layer)) {
+            solvePair_t pairs[64];
+            int num = 0;
+            pairs[num++] = team03_makeSolvePair(pos, score);
+            while ((ind = team03_nextMove(&picker)) >= 0)
+                pairs[num++] = team03_makeSolvePair(team03_getPosByIndex(ind), 0);
+            
+            int status = team03_split(state, color, layer, &alpha, beta, &best, &bestPos, pairs, num, 0);
+            if (status < 0) return team03_makeSolvePair(team03_makePos(-2, -2), 0);
+            if (alpha >= beta) {
+                team03_recordCutoff(state, color, layer, bestPos, 1);
+                team03_ttStore(key, alpha, layer, TEAM03_TT_LOWER, team03_getIndexByPos(bestPos));
+                return team03_makeSolvePair(bestPos, alpha);
+            }
+            break;
+        }
+    }
+    
+    // Remember the result for later iterations and moves
+    int bound = (best <= alphaOrig) ? TEAM03_TT_UPPER : TEAM03_TT_EXACT;
+    team03_ttStore(key, best, layer, bound, team03_getIndexByPos(bestPos));
+    
+    // Return the best move we found
+    solvePair_t pair = team03_makeSolvePair(bestPos, best);
+    return pair;
+}
+
+/**
+ * Searches a child node from the parent's point of view, i.e. the
+ * returned pair is the child's (opponent's) result for the window
+ * (-beta, -alpha). With PVS on, every child but the first is searched
+ * with a null window around alpha first, and only re-searched with the
+ * full window if it beats alpha.
+ *
+ * @param child the child board state
+ * @param color the color to move in the child
+ * @param layer the number of layers to search through
+ * @param alpha the parent's alpha
+ * @param beta the parent's beta
+ * @param first whether this is the parent's first (presumed best) move
+ *
+ * @return the child's result, as from `team03_solveBoard`
+ */
+solvePair_t team03_searchChild(board_t child, int color, int layer, int alpha, int beta, int first) {
+    if (first || !team03_usePVS || beta - alpha <= 1)
+        return team03_solveBoard(child, color, layer, -beta, -alpha);
+    
+    // Prove the move is no better than alpha; if it is, find out by how much
+    solvePair_t res = team03_solveBoard(child, color, layer, -alpha - 1, -alpha);
+    int score = 0 - res.score;
+    if (res.pos.x != -2 && score > alpha && score < beta)
+        res = team03_solveBoard(child, color, layer, -beta, -alpha);
+    return res;
+}
+
+/**
+ * Statically evaluates all of color's moves for the current board
+ * state, outputting a list pairing move positions with the static
+ * scores of the resulting positions in descending order of value.
+ * <br/><br/>
+ * If evaluate is 0, instead just gets the moves that are valid.
+ *
+ * @param state the current board state
+ * @param color the color to check moves for
+ * @param arr a pointer to an array solvePair_t[64]
+ * @param evaluate whether to evaluate and sort the move list before returning
+ * 
+ * @return the result array size
+ */
+int team03_getMoves(board_t state, int color, solvePair_t *arr, int evaluate) {
+    // # of valid moves we've found
+    int num = 0;
+    
+    // Walk the legal move mask from the lowest bit up (row-major order)
+    uint64_t moves = team03_getLegalMoves(state, color);
+    for (; moves; moves &= moves - 1) {
+        pos_t pos = team03_getPosByIndex(team03_bitScan(moves));
+        
+        // Compute the score for this move, the same way a 1-layer search
+        // would: the opponent's view of the position after it, negated
+        int score = 0;
+        if (evaluate) score = 0 - team03_evaluateStatic(team03_executeMove(state, pos, color), !color);
+        arr[num++] = team03_makeSolvePair(pos, score);
+    }
+    
+    // Sort the output array
+    if (num > 0 && evaluate) team03_sort(arr, 0, num - 1);
+    return num;
+}
+
+/**
+ * Ranks all of color's moves by a shallow full-window search of each
+ * resulting position, outputting them in descending order of score.
+ *
+ * @param state the current board state
+ * @param color the color to check moves for
+ * @param arr a pointer to an array solvePair_t[64]
+ * @param layers the depth to search each move to (counting the move)
+ *
+ * @return the result array size, or -1 if we ran out of time
+ */
+int team03_rankMoves(board_t state, int color, solvePair_t *arr, int layers) {
+    int num = team03_getMoves(state, color, arr, 0);
+    for (int i = 0; i < num; i++) {
+        board_t child = team03_executeMove(state, arr[i].pos, color);
+        solvePair_t res = team03_solveBoard(child, !color, layers - 1, -1e9, 1e9);
+        if (res.pos.x == -2) return -1;
+        arr[i].score = 0 - res.score;
+    }
+    
+    if (num > 0) team03_sort(arr, 0, num - 1);
+    return num;
+}
+
+
+/*
+ **********************
+ * Move ordering      *
+ **********************
+ */
+
+/**
+ * Sets up a move picker for an interior node.
+ *
+ * @param picker the picker to set up
+ * @param state the node's board state
+ * @param color the color to move
+ * @param moves the node's legal moves
+ * @param ttMove the bit index of the table's best move, or -1 if none
+ */
+void team03_initPicker(team03_picker_t *picker, board_t state, int color, uint64_t moves, int ttMove) {
+    int8_t *killers = team03_killers[team03_threadId][64 - team03_popcount(state.on)];
+    picker->moves = moves;
+    picker->stage = TEAM03_PICK_TT;
+    picker->color = color;
+    picker->ttMove = (int8_t) ttMove;
+    picker->killers[0] = killers[0], picker->killers[1] = killers[1];
+    picker->list = NULL;
+}
+
+/**
+ * Sets up a move picker that hands out an already ranked move list in
+ * order, skipping the stages.
+ *
+ * @param picker the picker to set up
+ * @param list the ranked moves; must outlive the picker
+ * @param num the number of moves
+ */
+void team03_initPickerList(team03_picker_t *picker, const solvePair_t *list, int num) {
+    picker->moves = 0;
+    for (int i = 0; i < num; i++) picker->moves |= 1ull << team03_getIndexByPos(list[i].pos);
+    picker->stage = TEAM03_PICK_LIST;
+    picker->list = list;
+    picker->next = 0;
+}
+
+/**
+ * Picks the next move to search: the transposition table's move, then
+ * corners, then this ply's killer moves, then the rest one at a time by
+ * their history and square scores. List pickers just go down the list.
+ *
+ * @param picker the node's move picker
+ *
+ * @return the move's bit index, or -1 if there are no moves left
+ */
+int team03_nextMove(team03_picker_t *picker) {
+    uint64_t moves = picker->moves;
+    if (!moves) return -1;
+    
+    switch (picker->stage) {
+        case TEAM03_PICK_LIST: {
+            int ind = team03_getIndexByPos(picker->list[picker->next++].pos);
+            picker->moves &= ~(1ull << ind);
+            return ind;
+        }
+        
+        case TEAM03_PICK_TT:
+            picker->stage = TEAM03_PICK_CORNERS;
+            if (picker->ttMove >= 0 && team03_getBit(moves, picker->ttMove)) {
+                picker->moves &= ~(1ull << picker->ttMove);
+                return picker->ttMove;
+            }
+            // fallthrough
+        
+        case TEAM03_PICK_CORNERS:
+            if (moves & TEAM03_CORNERS) {
+                int ind = team03_bitScan(moves & TEAM03_CORNERS);
+                picker->moves &= ~(1ull << ind);
+                return ind;
+            }
+            picker->stage = TEAM03_PICK_KILLERS;
+            // fallthrough
+        
+        case TEAM03_PICK_KILLERS:
+            for (int i = 0; i < 2; i++) {
+                int ind = picker->killers[i];
+                if (ind < 0 || !team03_getBit(moves, ind)) continue;
+                picker->killers[i] = -1;
+                picker->moves &= ~(1ull << ind);
+                return ind;
+            }
+            picker->stage = TEAM03_PICK_REST;
+            // fallthrough
+        
+        case TEAM03_PICK_REST:
+        default: {
+            // Selection: one pass over the remaining moves per pick
+            const int *history = team03_history[team03_threadId][picker->color];
+            int bestInd = -1, bestScore = -1e9;
+            for (; moves; moves &= moves - 1) {
+                int ind = team03_bitScan(moves);
+                int score = history[ind] * 8 + team03_squareScores[ind];
+                if (score > bestScore) bestScore = score, bestInd = ind;
+            }
+            picker->moves &= ~(1ull << bestInd);
+            return bestInd;
+        }
+    }
+}
+
+/**
+ * Records a beta cutoff: the move becomes this ply's first killer and
+ * its history score goes up by the square of the remaining depth.
+ *
+ * @param state the node's board state
+ * @param color the color to move
+ * @param layer the node's remaining depth
+ * @param move the move that caused the cutoff
+ * @param tried how many moves were searched before it
+ */
+void team03_recordCutoff(board_t state, int color, int layer, pos_t move, int tried) {
+    int ind = team03_getIndexByPos(move);
+    int8_t *killers = team03_killers[team03_threadId][64 - team03_popcount(state.on)];
+    if (killers[0] != ind) killers[1] = killers[0], killers[0] = ind;
+    
+    // Keep the history scores well below the killer scores
+    int *history = team03_history[team03_threadId][color];
+    history[ind] += layer * layer;
+    if (history[ind] >= 1 << 24)
+        for (int i = 0; i < 64; i++) history[i] /= 2;
+    
+    team03_orderStats_t *stats = &team03_orderStats[team03_threadId];
+    stats->cutoffs++;
+    if (tried == 0) stats->firstCutoffs++;
+}
+
+/**
+ * Halves every thread's history scores, so the ordering adapts as the
+ * game goes on. Called once per move.
+ */
+void team03_ageHistory(void) {
+    for (int t = 0; t < TEAM03_MAX_THREADS; t++)
+        for (int c = 0; c < 2; c++)
+            for (int i = 0; i < 64; i++) team03_history[t][c][i] /= 2;
+}
+
+/**
+ * Computes the share of beta cutoffs caused by the first move searched,
+ * over every thread and the whole game so far.
+ *
+ * @return the first-move cutoff rate in [0, 1], or 0 if there were none
+ */
+double team03_firstCutoffRate(void) {
+    long long cutoffs = 0, first = 0;
+    for (int i = 0; i < TEAM03_MAX_THREADS; i++) {
+        cutoffs += team03_orderStats[i].cutoffs;
+        first += team03_orderStats[i].firstCutoffs;
+    }
+    return cutoffs ? (double) first / cutoffs : 0.0;
+}
+
+
+/*
+ **********************
+ * Endgame solver     *
+ **********************
+ */
+
+/**
+ * Picks a move for a position near the end of the game. Iterative
+ * deepening (with the helpers) orders the moves and gives a fallback,
+ * then every thread works on proving the outcome and, if there are few
+ * enough empties, finding the exact score. The best move from the last
+ * search or solve to finish is played.
+ *
+ * @param state the current board state
+ * @param color our color
+ * @param moveList the root moves
+ * @param num the number of root moves
+ *
+ * @return the position we place a piece at
+ */
+pos_t team03_iterateEndgame(board_t state, int color, solvePair_t *moveList, int num) {
+    // Heuristic search first, so we have something if the solve times out;
+    // past the presearch, only start a depth while there's time to spare
+    int empties = 64 - team03_popcount(state.on), scores[TEAM03_MAX_LAYERS + 1];
+    pos_t retPos = moveList[0].pos;
+    team03_startHelpers(state, color, moveList, num, 0);
+    for (int layers = 1; layers <= empties && layers <= team03_maxLayers; layers++) {
+        if (layers > TEAM03_ENDGAME_PRESEARCH
+            && team03_timeSinceMs(team03_startTime) * 100 >= team03_maxTime * TEAM03_ENDGAME_DEEPEN_SHARE)
+            break;
+        int center = (layers > 2) ? scores[layers - 2] : 0;
+        pos_t pos = team03_aspirate(state, color, moveList, num, layers, center, &retPos);
+        team03_recordIteration("midgame", layers, pos.x != -2);
+        if (pos.x == -2) {
+            team03_stopHelpers();
+            return retPos;
+        }
+        retPos = pos;
+        scores[layers] = moveList[0].score;
+    }
+    
+    // Then put the helpers on the solve too (stopping them raises the
+    // stop flag, so lower it again if there's time left)
+    team03_stopHelpers();
+    if (!team03_resumeTimer()) return retPos;
+    team03_startHelpers(state, color, moveList, num, 1);
+    
+    // Prove the outcome with a null window around a draw; the score is
+    // then only its sign, but that's far cheaper than the exact score
+    solvePair_t res = team03_solveEndgameRoot(state, color, moveList, num, -1, 1);
+    team03_recordIteration("wld", empties, res.pos.x != -2);
+    if (res.pos.x != -2) retPos = res.pos;
+
+#if TEAM03_DEBUG
+    // Print the outcome
+    if (res.pos.x == -2) printf("Endgame WLD solve " ANSI_RED "timed out\n" ANSI_RESET);
+    else printf("Proved endgame " ANSI_CYAN "%s\n" ANSI_RESET,
+                res.score > 0 ? "win" : res.score < 0 ? "loss" : "draw");
+#endif
+    
+    // If it's close enough, find the exact score on the proven side of zero
+    // (a draw is already exact); keep the WLD move if we run out of time
+    if (res.pos.x == -2 || res.score == 0 || empties > TEAM03_ENDGAME_EMPTIES) {
+        team03_stopHelpers();
+        return retPos;
+    }
+    int alpha = (res.score > 0) ? 0 : -65, beta = (res.score > 0) ? 65 : 0;
+    res = team03_solveEndgameRoot(state, color, moveList, num, alpha, beta);
+    team03_stopHelpers();
+    team03_recordIteration("exact", empties, res.pos.x != -2);
+
+#if TEAM03_DEBUG
+    // Print the result of the solve
+    if (res.pos.x == -2) printf("Endgame solve " ANSI_RED "timed out\n" ANSI_RESET);
+    else printf("Solved endgame: final score " ANSI_CYAN "%+d\n" ANSI_RESET, res.score);
+#endif
+    return (res.pos.x == -2) ? retPos : res.pos;
+}
+
+/**
+ * Solves the root of an endgame exactly, searching the moves in the
+ * order given and updating their scores (exact only within the window).
+ * Under YBWC, the moves after the first are shared between threads.
+ *
+ * @param state the current board state
+ * @param color the color to move
+ * @param moveList the root moves; re-sorted on the updated scores
+ * @param num the number of root moves
+ * @param alpha the root's alpha, in discs
+ * @param beta the root's beta, in discs
+ *
+ * @return the best move and its final disc differential, or position
+ * (-2, -2) if we ran out of time
+ */
+solvePair_t team03_solveEndgameRoot(board_t state, int color, solvePair_t *moveList, int num,
+                                    int alpha, int beta) {
+    team03_endgame_t eg;
+    int parity = team03_initEmpties(&eg, state);
+    int empties = 64 - team03_popcount(state.on);
+    
+    int best = -65;
+    pos_t bestPos = moveList[0].pos;
+    for (int i = 0; i < num; i++) {
+        // Take the move's square out of the list while it's searched
+        int8_t ind = team03_getIndexByPos(moveList[i].pos);
+        team03_empty_t *sq = &eg.squares[ind];
+        sq->prev->next = sq->next, sq->next->prev = sq->prev;
+        
+        board_t cur = team03_executeMove(state, moveList[i].pos, color);
+        solvePair_t res = team03_solveEndgame(&eg, cur, !color, -beta, -alpha,
+                                              empties - 1, parity ^ sq->quadrant, 0);
+        sq->prev->next = sq, sq->next->prev = sq;
+        if (res.pos.x == -2) {
+            team03_nodeStats[team03_threadId].nodes += eg.nodes;
+            return res;
+        }
+        
+        int score = 0 - res.score;
+        moveList[i].score = score;
+        if (score > best) best = score, bestPos = moveList[i].pos;
+        if (score > alpha) alpha = score;
+        if (alpha >= beta) break;
+        
+        // Under YBWC, the rest of the moves are shared once the first is in
+        if (i == 0 && num > 1 && team03_canSplitEndgame(empties)) {
+            if (team03_split(state, color, empties, &alpha, beta, &best, &bestPos, moveList, num, 1) < 0) {
+                team03_nodeStats[team03_threadId].nodes += eg.nodes;
+                return team03_makeSolvePair(team03_makePos(-2, -2), 0);
+            }
+            break;
+        }
+    }
+    
+    team03_nodeStats[team03_threadId].nodes += eg.nodes;
+    team03_sort(moveList, 0, num - 1);
+    return team03_makeSolvePair(bestPos, best);
+}
+
+/**
+ * Builds the endgame solver's list of empties (best squares first) and
+ * the parity mask for a position.
+ *
+ * @param eg the solver state to fill in
+ * @param state the board state
+ *
+ * @return the parity mask: bit q is set if quadrant q has an odd number
+ * of empties
+ */
+int team03_initEmpties(team03_endgame_t *eg, board_t state) {
+    eg->head.prev = eg->head.next = &eg->head;
+    eg->head.square = -1;
+    eg->nodes = 0;
+    
+    // Insert the empties corners first, then in order of their square scores
+    int parity = 0;
+    for (int rank = 3; rank >= -3; rank--) {
+        for (int8_t ind = 0; ind < 64; ind++) {
+            int corner = (int) ((TEAM03_CORNERS >> ind) & 1);
+            if (team03_getBit(state.on, ind) || (corner ? 3 : team03_squareScores[ind]) != rank) continue;
+            
+            team03_empty_t *sq = &eg->squares[ind];
+            sq->square = ind;
+            sq->quadrant = (uint8_t) (1 << (((ind >> 5) & 1) * 2 + ((ind >> 2) & 1)));
+            sq->prev = eg->head.prev, sq->next = &eg->head;
+            eg->head.prev->next = sq, eg->head.prev = sq;
+            parity ^= sq->quadrant;
+        }
+    }
+    return parity;
+}
+
+/**
+ * Solves a position exactly with alpha-beta, returning the final disc
+ * differential (fail-soft). With many empties, moves are tried fastest
+ * first, i.e. by the opponent's mobility after them; near the end they're
+ * just taken from the empties list, odd quadrants first. No static
+ * evaluation is involved. Under YBWC, nodes with TEAM03_YBWC_MIN_EMPTIES
+ * or more empties are split once their eldest child is solved.
+ *
+ * @param eg the solver state; its list must match the board
+ * @param state the board state
+ * @param color the color to move
+ * @param alpha the alpha, in discs
+ * @param beta the beta, in discs
+ * @param empties the number of empty squares
+ * @param parity the parity mask (see `team03_initEmpties`)
+ * @param passed whether the last move was a pass
+ *
+ * @return the best move and its score, or position (-2, -2) if we ran
+ * out of time
+ */
+solvePair_t team03_solveEndgame(team03_endgame_t *eg, board_t state, int color, int alpha, int beta,
+                                int empties, int parity, int passed) {
+    eg->nodes++;
+
+    // Check for a timeout or a cutoff at a split point above us, where the
+    // subtree is big enough to be worth it
+    if (empties >= TEAM03_ENDGAME_FASTEST && (team03_timeUp() || team03_splitAborted(team03_curSplit)))
+        return team03_makeSolvePair(team03_makePos(-2, -2), 0);
+    
+    // The last few empties have kernels of their own; odd quadrants first
+    if (empties <= 4) {
+        int8_t sqs[4];
+        int n = 0, score = 0;
+        for (int odd = 1; odd >= 0; odd--)
+            for (team03_empty_t *sq = eg->head.next; sq != &eg->head; sq = sq->next)
+                if (((parity & sq->quadrant) != 0) == odd) sqs[n++] = sq->square;
+        
+        switch (empties) {
+            case 0: score = team03_finalScore(state, color); break;
+            case 1: score = team03_solveLast1(state, color, sqs[0]); break;
+            case 2: score = team03_solveLast2(state, color, alpha, beta, sqs, 0); break;
+            case 3: score = team03_solveLast3(state, color, alpha, beta, sqs, 0); break;
+            default: score = team03_solveLast4(state, color, alpha, beta, sqs, 0); break;
+        }
+        eg->nodes++;
+        return team03_makeSolvePair(team03_makePos(-1, -1), score);
+    }
+
+    // Stability cutoffs: the opponent's stable discs cap our final score,
+    // and our own put a floor under it. The disc counts bound both bounds,
+    // so the stability check only runs when it could possibly cut.
+    if (empties >= TEAM03_ENDGAME_STABILITY_MIN) {
+        if (64 - 2 * team03_count(state, !color) <= alpha) {
+            int upper = 64 - 2 * team03_popcount(team03_getStable(state, !color));
+            if (upper <= alpha) return team03_makeSolvePair(team03_makePos(-1, -1), upper);
+        }
+        if (2 * team03_count(state, color) - 64 >= beta) {
+            int lower = 2 * team03_popcount(team03_getStable(state, color)) - 64;
+            if (lower >= beta) return team03_makeSolvePair(team03_makePos(-1, -1), lower);
+        }
+    }
+    
+    // Check the table (under keys of their own, since scores are in discs)
+    int useTT = empties >= TEAM03_ENDGAME_TT_MIN, alphaOrig = alpha, ttMove = -1;
+    uint64_t key = 0;
+    team03_ttData_t tt;
+    if (useTT && team03_ttProbe(key = team03_hashKey(state, color) ^ team03_zobristEndgame, &tt)) {
+        ttMove = tt.move;
+        if (tt.bound == TEAM03_TT_EXACT
+            || (tt.bound == TEAM03_TT_LOWER && tt.score >= beta)
+            || (tt.bound == TEAM03_TT_UPPER && tt.score <= alpha)) {
+            pos_t pos = ttMove < 0 ? team03_makePos(-1, -1) : team03_getPosByIndex(ttMove);
+            return team03_makeSolvePair(pos, tt.score);
+        }
+    }
+
+    int best = -65, bestInd = -1, moved = 0;
+    if (empties > TEAM03_ENDGAME_FASTEST) {
+        // Fastest first: play every move, then search the ones leaving the
+        // opponent the fewest replies first (odd quadrants breaking ties)
+        board_t children[64];
+        int8_t inds[64];
+        int keys[64], num = 0;
+        uint64_t moves = team03_getLegalMoves(state, color);
+        for (; moves; moves &= moves - 1) {
+            int8_t ind = (int8_t) team03_bitScan(moves);
+            board_t child = team03_playFlips(state, ind, team03_computeFlips(state, ind, color), color,
+                                             empties - 1 >= TEAM03_ENDGAME_TT_MIN);
+            int k = (ind == ttMove) ? -1000 : team03_computeMobility(child, !color) * 2
+                                               - ((parity & eg->squares[ind].quadrant) != 0);
+
+            // Insertion sort on the key as we go
+            int i = num++;
+            for (; i > 0 && keys[i - 1] > k; i--)
+                children[i] = children[i - 1], inds[i] = inds[i - 1], keys[i] = keys[i - 1];
+            children[i] = child, inds[i] = ind, keys[i] = k;
+        }
+
+        for (int i = 0; i < num; i++) {
+            moved = 1;
+            team03_empty_t *sq = &eg->squares[inds[i]];
+            sq->prev->next = sq->next, sq->next->prev = sq->prev;
+            // (PVS: after the first move, prove the rest are no better first)
+            int lo = (i == 0) ? -beta : -alpha - 1;
+            solvePair_t res = team03_solveEndgame(eg, children[i], !color, lo, -alpha,
+                                                  empties - 1, parity ^ sq->quadrant, 0);
+            if (lo != -beta && res.pos.x != -2 && -res.score > alpha && -res.score < beta)
+                res = team03_solveEndgame(eg, children[i], !color, -beta, -alpha,
+                                          empties - 1, parity ^ sq->quadrant, 0);
+            sq->prev->next = sq, sq->next->prev = sq;
+            if (res.pos.x == -2) return res;
+
+            int score = 0 - res.score;
+            if (score > best) best = score, bestInd = inds[i];
+            if (score > alpha) alpha = score;
+            if (alpha >= beta) break;
+            
+            // Young Brothers Wait, as in `team03_solveNode`
+            if (i == 0 && num > 1 && team03_canSplitEndgame(empties)) {
+                solvePair_t pairs[64];
+                for (int k = 0; k < num; k++) pairs[k] = team03_makeSolvePair(team03_getPosByIndex(inds[k]), 0);
+                pos_t bestPos = team03_getPosByIndex((int8_t) bestInd);
+                if (team03_split(state, color, empties, &alpha, beta, &best, &bestPos, pairs, num, 1) < 0)
+                    return team03_makeSolvePair(team03_makePos(-2, -2), 0);
+                bestInd = team03_getIndexByPos(bestPos);
+                break;
+            }
+        }
+    } else {
+        // Near the end: straight off the list, odd quadrants first
+        uint64_t opp = team03_getPieces(state, !color);
+        for (int odd = 1; odd >= 0 && alpha < beta; odd--) {
+            for (team03_empty_t *sq = eg->head.next; sq != &eg->head; sq = sq->next) {
+                if (((parity & sq->quadrant) != 0) != odd || !(opp & team03_neighbours[sq->square])) continue;
+                uint64_t flips = team03_computeFlips(state, sq->square, color);
+                if (!flips) continue;
+
+                moved = 1;
+                sq->prev->next = sq->next, sq->next->prev = sq->prev;
+                board_t cur = team03_playFlips(state, sq->square, flips, color, 0);
+                solvePair_t res = team03_solveEndgame(eg, cur, !color, -beta, -alpha,
+                                                      empties - 1, parity ^ sq->quadrant, 0);
+                sq->prev->next = sq, sq->next->prev = sq;
+                if (res.pos.x == -2) return res;
+
+                int score = 0 - res.score;
+                if (score > best) best = score, bestInd = sq->square;
+                if (score > alpha) alpha = score;
+                if (alpha >= beta) break;
+            }
+        }
+    }
+
+    // No moves: pass, or the game is over if the opponent just passed too
+    if (!moved) {
+        if (passed) return team03_makeSolvePair(team03_makePos(-1, -1), team03_finalScore(state, color));
+        solvePair_t res = team03_solveEndgame(eg, state, !color, -beta, -alpha, empties, parity, 1);
+        res.score = 0 - res.score;
+        return res;
+    }
+
+    // Remember the result; exact solves don't go stale, so the depth is moot
+    if (useTT) {
+        int bound = (best <= alphaOrig) ? TEAM03_TT_UPPER : (best >= beta) ? TEAM03_TT_LOWER : TEAM03_TT_EXACT;
+        team03_ttStore(key, best, empties, bound, bestInd);
+    }
+    return team03_makeSolvePair(team03_getPosByIndex((int8_t) bestInd), best);
+}
+
+/**
+ * Solves a position with one empty square left. No child board is built;
+ * the score follows from the number of discs the last move flips.
+ *
+ * @param state the board state
+ * @param color the color to move
+ * @param sq the bit index of the empty square
+ *
+ * @return the final disc differential
+ */
+int team03_solveLast1(board_t state, int color, int8_t sq) {
+    int score = team03_finalScore(state, color);
+    
+    // Whoever can play the square gains the placed disc plus twice the flips
+    uint64_t near = state.on & team03_neighbours[sq];
+    int flips = (near & team03_getPieces(state, !color)) ? team03_popcount(team03_computeFlips(state, sq, color)) : 0;
+    if (flips) return score + 2 * flips + 1;
+    flips = (near & team03_getPieces(state, color)) ? team03_popcount(team03_computeFlips(state, sq, !color)) : 0;
+    if (flips) return score - 2 * flips - 1;
+    return score;
+}
+
+/**
+ * Solves a position with two empty squares left.
+ *
+ * @param state the board state
+ * @param color the color to move
+ * @param alpha the alpha, in discs
+ * @param beta the beta, in discs
+ * @param sqs the bit indices of the empty squares
+ * @param passed whether the last move was a pass
+ *
+ * @return the final disc differential (fail-soft)
+ */
+int team03_solveLast2(board_t state, int color, int alpha, int beta, const int8_t *sqs, int passed) {
+    int best = -65;
+    uint64_t opp = team03_getPieces(state, !color);
+    uint64_t flips = (opp & team03_neighbours[sqs[0]]) ? team03_computeFlips(state, sqs[0], color) : 0;
+    if (flips) {
+        best = 0 - team03_solveLast1(team03_playFlips(state, sqs[0], flips, color, 0), !color, sqs[1]);
+        if (best >= beta) return best;
+    }
+    flips = (opp & team03_neighbours[sqs[1]]) ? team03_computeFlips(state, sqs[1], color) : 0;
+    if (flips) {
+        int score = 0 - team03_solveLast1(team03_playFlips(state, sqs[1], flips, color, 0), !color, sqs[0]);
+        if (score > best) best = score;
+    }
+    if (best > -65) return best;
+    
+    // No moves: pass, or the game is over
+    if (passed) return team03_finalScore(state, color);
+    return 0 - team03_solveLast2(state, !color, -beta, -alpha, sqs, 1);
+}
+
+/**
+ * Solves a position with three empty squares left.
+ *
+ * @param state the board state
+ * @param color the color to move
+ * @param alpha the alpha, in discs
+ * @param beta the beta, in discs
+ * @param sqs the bit indices of the empty squares, best first
+ * @param passed whether the last move was a pass
+ *
+ * @return the final disc differential (fail-soft)
+ */
+int team03_solveLast3(board_t state, int color, int alpha, int beta, const int8_t *sqs, int passed) {
+    int best = -65;
+    const int8_t rest[3][2] = {{sqs[1], sqs[2]}, {sqs[0], sqs[2]}, {sqs[0], sqs[1]}};
+    uint64_t opp = team03_getPieces(state, !color);
+    for (int i = 0; i < 3; i++) {
+        if (!(opp & team03_neighbours[sqs[i]])) continue;
+        uint64_t flips = team03_computeFlips(state, sqs[i], color);
+        if (!flips) continue;
+        
+        board_t cur = team03_playFlips(state, sqs[i], flips, color, 0);
+        int score = 0 - team03_solveLast2(cur, !color, -beta, -alpha, rest[i], 0);
+        if (score > best) {
+            best = score;
+            if (score >= beta) return best;
+            if (score > alpha) alpha = score;
+        }
+    }
+    if (best > -65) return best;
+    
+    // No moves: pass, or the game is over
+    if (passed) return team03_finalScore(state, color);
+    return 0 - team03_solveLast3(state, !color, -beta, -alpha, sqs, 1);
+}
+
+/**
+ * Solves a position with four empty squares left.
+ *
+ * @param state the board state
+ * @param color the color to move
+ * @param alpha the alpha, in discs
+ * @param beta the beta, in discs
+ * @param sqs the bit indices of the empty squares, best first
+ * @param passed whether the last move was a pass
+ *
+ * @return the final disc differential (fail-soft)
+ */
+int team03_solveLast4(board_t state, int color, int alpha, int beta, const int8_t *sqs, int passed) {
+    int best = -65;
+    const int8_t rest[4][3] = {
+            {sqs[1], sqs[2], sqs[3]},
+            {sqs[0], sqs[2], sqs[3]},
+            {sqs[0], sqs[1], sqs[3]},
+            {sqs[0], sqs[1], sqs[2]}
+    };
+    uint64_t opp = team03_getPieces(state, !color);
+    for (int i = 0; i < 4; i++) {
+        if (!(opp & team03_neighbours[sqs[i]])) continue;
+        uint64_t flips = team03_computeFlips(state, sqs[i], color);
+        if (!flips) continue;
+        
+        board_t cur = team03_playFlips(state, sqs[i], flips, color, 0);
+        int score = 0 - team03_solveLast3(cur, !color, -beta, -alpha, rest[i], 0);
+        if (score > best) {
+            best = score;
+            if (score >= beta) return best;
+            if (score > alpha) alpha = score;
+        }
+    }
+    if (best > -65) return best;
+    
+    // No moves: pass, or the game is over
+    if (passed) return team03_finalScore(state, color);
+    return 0 - team03_solveLast4(state, !color, -beta, -alpha, sqs, 1);
+}
+
+/**
+ * Plays a move whose flips are already known. Only keeps the hash up to
+ * date if asked to, since the solver's small subtrees don't need it.
+ *
+ * @param state the board state
+ * @param ind the bit index of the move
+ * @param flips the pieces it flips
+ * @param color the color moving
+ * @param hashed whether to update the hash
+ *
+ * @return the new board state
+ */
+board_t team03_playFlips(board_t state, int8_t ind, uint64_t flips, int color, int hashed) {
+    uint64_t bit = 1ull << ind;
+    state.on |= bit;
+    state.color = (state.color & ~bit) ^ (flips | (bit & (0 - (uint64_t) color)));
+    if (!hashed) return state;
+    
+    state.hash ^= team03_zobrist[color][ind];
+    for (; flips; flips &= flips - 1)
+        state.hash ^= team03_zobristFlip[team03_bitScan(flips)];
+    return state;
+}
+
+/**
+ * Computes the final disc differential of a finished game.
+ *
+ * @param state the board state
+ * @param color the color to score for
+ *
+ * @return color's discs minus the opponent's
+ */
+int team03_finalScore(board_t state, int color) {
+    return team03_count(state, color) - team03_count(state, !color);
+}
+
+
+/*
+ **********************
+ * Pondering          *
+ **********************
+ */
+
+/**
+ * Starts pondering on the position after our move: a background thread
+ * searches every reply (or, if the opponent has to pass, our next move)
+ * with no time limit until `team03_stopPonder` is called. Near the end
+ * it runs the endgame solves instead, so their table entries are there.
+ * The table is aged here rather than in `team03_getMove`, so the entries
+ * are the same age as the next move's own.
+ *
+ * @param state the board state after our move
+ * @param color the color to move (the opponent)
+ */
+void team03_startPonder(board_t state, int color) {
+#ifdef TEAM03_IS_POSIX
+    team03_helper_t *ponder = &team03_ponder;
+    ponder->num = team03_getMoves(state, color, ponder->moveList, 1);
+    if (!ponder->num) ponder->num = team03_getMoves(state, color ^= 1, ponder->moveList, 1);
+    if (!ponder->num) return;
+    ponder->state = state;
+    ponder->color = color;
+    
+    // Nothing to time out on; it runs until stopped
+    TEAM03_STORE(team03_stop, 0);
+    team03_deadline = TEAM03_NO_DEADLINE;
+    team03_ttNewSearch();
+    ponder->running = !pthread_create(&ponder->thread, NULL, team03_ponderMain, ponder);
+    team03_pondered = ponder->running;
+#endif
+}
+
+/**
+ * Stops the pondering thread, if it's running, and waits for it to
+ * unwind.
+ */
+void team03_stopPonder(void) {
+#ifdef TEAM03_IS_POSIX
+    if (!team03_ponder.running) return;
+    TEAM03_STORE(team03_stop, 1);
+    pthread_join(team03_ponder.thread, NULL);
+    team03_ponder.running = 0;
+    TEAM03_STORE(team03_stop, 0);
+#endif
+}
+
+/**
+ * Entry point for the pondering thread: iterative deepening over the
+ * pondered position's moves, or the endgame solves if it's close enough
+ * to the end, until it's stopped. Results only land in the transposition
+ * table.
+ *
+ * @param arg the ponder thread's `team03_helper_t`
+ *
+ * @return NULL
+ */
+void *team03_ponderMain(void *arg) {
+    team03_helper_t *ponder = (team03_helper_t *) arg;
+    int empties = 64 - team03_popcount(ponder->state.on);
+    
+    if (empties <= TEAM03_WLD_EMPTIES) {
+        team03_solveHelper(ponder);
+        return NULL;
+    }
+    
+    for (int layers = 1; layers <= team03_maxLayers; layers++) {
+        pos_t pos = team03_searchRoot(ponder->state, ponder->color,
+                                      ponder->moveList, ponder->num, layers, -1e9, 1e9);
+        if (pos.x == -2) break;
+    }
+    return NULL;
+}
+
+
+/*
+ **********************
+ * Search timer       *
+ **********************
+ */
+
+/**
+ * Arms the deadline for a search, `team03_maxTime` ms after
+ * `team03_startTime` but on the monotonic clock, and clears the stop
+ * flag. On POSIX a timer thread raises the flag when the deadline passes;
+ * otherwise (or if the thread can't be created) the searches notice by
+ * checking the clock now and then, in `team03_timeUp`.
+ */
+void team03_startTimer(void) {
+    team03_deadline = team03_nowMs() + team03_maxTime - team03_timeSinceMs(team03_startTime);
+    TEAM03_STORE(team03_stop, 0);
+#ifdef TEAM03_IS_POSIX
+    TEAM03_STORE(team03_timerCancel, 0);
+    team03_timerRunning = !pthread_create(&team03_timerThread, NULL, team03_timerMain, NULL);
+#endif
+}
+
+/**
+ * Stops the timer thread, if it's running, and waits for it to exit.
+ */
+void team03_stopTimer(void) {
+#ifdef TEAM03_IS_POSIX
+    if (!team03_timerRunning) return;
+    TEAM03_STORE(team03_timerCancel, 1);
+    pthread_join(team03_timerThread, NULL);
+    team03_timerRunning = 0;
+#endif
+}
+
+/**
+ * Lowers the stop flag again after the helpers were stopped mid-move,
+ * unless the deadline has passed. The deadline is checked after the flag
+ * is lowered, so a timer firing in between can't be lost.
+ *
+ * @return 1 if there's still time to search; otherwise 0
+ */
+int team03_resumeTimer(void) {
+    TEAM03_STORE(team03_stop, 0);
+    if (team03_nowMs() < team03_deadline) return 1;
+    TEAM03_STORE(team03_stop, 1);
+    return 0;
+}
+
+/**
+ * Entry point for the timer thread: sleeps in short slices until the
+ * deadline passes or the timer is stopped, then raises `team03_stop`.
+ *
+ * @param arg unused
+ *
+ * @return NULL
+ */
+void *team03_timerMain(void *arg) {
+    (void) arg;
+#ifdef TEAM03_IS_POSIX
+    // Short slices, so stopping the timer never holds up the move
+    const struct timespec slice = { 0, 1000000 };
+    while (!TEAM03_LOAD(team03_timerCancel)) {
+        if (team03_nowMs() >= team03_deadline) {
+            TEAM03_STORE(team03_stop, 1);
+            break;
+        }
+        nanosleep(&slice, NULL);
+    }
+#endif
+    return NULL;
+}
+
+/**
+ * Checks whether the search should unwind. Usually just a load of the
+ * stop flag; every `TEAM03_POLL_NODES` calls per thread it also checks
+ * the deadline itself, raising the flag if it's passed.
+ *
+ * @return 1 if the search should stop, 0 otherwise
+ */
+int team03_timeUp(void) {
+    if (TEAM03_LOAD(team03_stop)) return 1;
+    if (++team03_pollCount & (TEAM03_POLL_NODES - 1)) return 0;
+    
+    // Fallback for when there's no timer thread (or it's running late)
+    if (team03_nowMs() < team03_deadline) return 0;
+    TEAM03_STORE(team03_stop, 1);
+    return 1;
+}
+
+
+/*
+ **********************
+ * Search statistics  *
+ **********************
+ */
+
+/**
+ * Sums the search counters over every thread.
+ *
+ * @return the summed counters
+ */
+team03_nodeStats_t team03_sumNodeStats(void) {
+    team03_nodeStats_t sum;
+    memset(&sum, 0, sizeof(sum));
+    for (int i = 0; i < TEAM03_MAX_THREADS; i++) {
+        sum.nodes += team03_nodeStats[i].nodes;
+        sum.leaves += team03_nodeStats[i].leaves;
+        sum.ttProbes += team03_nodeStats[i].ttProbes;
+        sum.ttHits += team03_nodeStats[i].ttHits;
+        sum.cutoffs += team03_orderStats[i].cutoffs;
+        sum.firstCutoffs += team03_orderStats[i].firstCutoffs;
+    }
+    return sum;
+}
+
+/**
+ * Starts collecting statistics for a move's search.
+ *
+ * @param state the board state being searched
+ * @param color our color
+ */
+void team03_startStats(board_t state, int color) {
+    team03_moveStats_t *stats = &team03_moveStats;
+    memset(stats, 0, sizeof(*stats));
+    stats->turn = team03_getTurnNum(state, color);
+    stats->color = color;
+    stats->move = team03_makePos(-1, -1);
+    
+    team03_statsBase = team03_statsMark = team03_sumNodeStats();
+    team03_statsStart = team03_iterStart = team03_nowMs();
+}
+
+/**
+ * Records an iteration of the current move's search: the nodes searched
+ * and the time taken since the last one.
+ *
+ * @param search the kind of search ("midgame", "wld" or "exact")
+ * @param depth the layers searched, or empties solved
+ * @param complete whether it finished in time
+ */
+void team03_recordIteration(const char *search, int depth, int complete) {
+    team03_moveStats_t *stats = &team03_moveStats;
+    team03_nodeStats_t now = team03_sumNodeStats();
+    long long ms = team03_nowMs();
+    
+    if (stats->numIters < (int) (sizeof(stats->iters) / sizeof(stats->iters[0]))) {
+        team03_iterStats_t *iter = &stats->iters[stats->numIters++];
+        iter->search = search;
+        iter->depth = depth;
+        iter->complete = complete;
+        iter->nodes = now.nodes - team03_statsMark.nodes;
+        iter->leaves = now.leaves - team03_statsMark.leaves;
+        iter->ms = ms - team03_iterStart;
+    }
+    if (complete && depth > stats->depth) stats->depth = depth;
+    team03_statsMark = now;
+    team03_iterStart = ms;
+}
+
+/**
+ * Finishes the current move's statistics and, if there's a stats file,
+ * writes them out.
+ *
+ * @param move the move we chose
+ */
+void team03_finishStats(pos_t move) {
+    team03_moveStats_t *stats = &team03_moveStats;
+    team03_nodeStats_t now = team03_sumNodeStats();
+    stats->move = move;
+    stats->ms = team03_nowMs() - team03_statsStart;
+    
+    // Counters run over the whole game, so take what this move added
+    stats->totals.nodes = now.nodes - team03_statsBase.nodes;
+    stats->totals.leaves = now.leaves - team03_statsBase.leaves;
+    stats->totals.ttProbes = now.ttProbes - team03_statsBase.ttProbes;
+    stats->totals.ttHits = now.ttHits - team03_statsBase.ttHits;
+    stats->totals.cutoffs = now.cutoffs - team03_statsBase.cutoffs;
+    stats->totals.firstCutoffs = now.firstCutoffs - team03_statsBase.firstCutoffs;
+    
+    if (team03_statsOut) team03_writeStats(team03_statsOut, stats);
+}
+
+/**
+ * Writes a move's statistics as a single JSON line.
+ *
+ * @param out the file to write to
+ * @param stats the statistics
+ */
+void team03_writeStats(FILE *out, const team03_moveStats_t *stats) {
+    const team03_nodeStats_t *t = &stats->totals;
+    fprintf(out, "{\"turn\":%d,\"color\":\"%s\",\"move\":{\"x\":%d,\"y\":%d},\"depth\":%d,"
+                 "\"ms\":%lld,\"nodes\":%lld,\"leaves\":%lld,\"nps\":%lld,"
+                 "\"cutoffs\":%lld,\"firstCutoffRate\":%.4f,\"ttProbes\":%lld,\"ttHitRate\":%.4f,"
+                 "\"iterations\":[",
+            stats->turn, stats->color ? "white" : "black", stats->move.x, stats->move.y, stats->depth,
+            stats->ms, t->nodes, t->leaves, stats->ms ? t->nodes * 1000 / stats->ms : t->nodes,
+            t->cutoffs, t->cutoffs ? (double) t->firstCutoffs / t->cutoffs : 0.0,
+            t->ttProbes, t->ttProbes ? (double) t->ttHits / t->ttProbes : 0.0);
+    for (int i = 0; i < stats->numIters; i++) {
+        const team03_iterStats_t *iter = &stats->iters[i];
+        fprintf(out, "%s{\"search\":\"%s\",\"depth\":%d,\"complete\":%s,"
+                     "\"nodes\":%lld,\"leaves\":%lld,\"ms\":%lld}",
+                i ? "," : "", iter->search, iter->depth, iter->complete ? "true" : "false",
+                iter->nodes, iter->leaves, iter->ms);
+    }
+    fprintf(out, "]}\n");
+    fflush(out);
+}
+
+
+/*
+ **********************
+ * Lazy SMP           *
+ **********************
+ */
+
+/**
+ * Starts the helper threads on a search of the given root position. Each
+ * helper gets its own copy of the move list, rotated by its id so the
+ * helpers don't all walk the tree in the same order, and starts at a
+ * staggered depth (or, in the endgame, runs the same solves as us). YBWC
+ * helpers ignore the position and steal work from our split points.
+ *
+ * @param state the root board state
+ * @param color the color to move
+ * @param moveList the root moves, best first
+ * @param num the number of root moves
+ * @param endgame 1 to solve the position instead of searching it
+ */
+void team03_startHelpers(board_t state, int color, const solvePair_t *moveList, int num, int endgame) {
+#ifdef TEAM03_IS_POSIX
+    for (int i = 1; i < team03_numThreads; i++) {
+        team03_helper_t *helper = &team03_helpers[i];
+        helper->id = i;
+        helper->endgame = endgame;
+        helper->state = state;
+        helper->color = color;
+        helper->num = num;
+        for (int j = 0; j < num; j++) helper->moveList[j] = moveList[(j + i) % num];
+        
+        // If we can't get a thread, search with the ones we have
+        helper->running = !pthread_create(&helper->thread, NULL, team03_helperMain, helper);
+    }
+#endif
+}
+
+/**
+ * Signals the helper threads to stop and waits for them to exit.
+ */
+void team03_stopHelpers(void) {
+    TEAM03_STORE(team03_stop, 1);
+#ifdef TEAM03_IS_POSIX
+    for (int i = 1; i < team03_numThreads; i++) {
+        if (!team03_helpers[i].running) continue;
+        pthread_join(team03_helpers[i].thread, NULL);
+        team03_helpers[i].running = 0;
+    }
+#endif
+}
+
+/**
+ * Entry point for a helper thread. Runs iterative deepening on the
+ * helper's root position until the main thread stops it or time runs
+ * out; odd helpers start one layer deeper, so at any time the threads
+ * are spread over two depths. Results only land in the transposition
+ * table. Under YBWC, helpers only steal work from split points instead,
+ * in the endgame solver as well as in the search.
+ *
+ * @param arg the helper's `team03_helper_t`
+ *
+ * @return NULL
+ */
+void *team03_helperMain(void *arg) {
+    team03_helper_t *helper = (team03_helper_t *) arg;
+    team03_threadId = helper->id;
+    
+    // YBWC helpers don't search on their own; they just steal split points
+    // (the endgame solver's too)
+    if (team03_parallel == TEAM03_PARALLEL_YBWC) {
+        while (!TEAM03_LOAD(team03_stop)) if (!team03_steal(NULL)) team03_yield();
+        return NULL;
+    }
+    
+    // Lazy SMP endgame helpers run the solves, sharing results in the table
+    if (helper->endgame) {
+        team03_solveHelper(helper);
+        return NULL;
+    }
+    
+    for (int layers = 1 + (helper->id & 1); layers <= team03_maxLayers; layers++) {
+        pos_t pos = team03_searchRoot(helper->state, helper->color,
+                                      helper->moveList, helper->num, layers, -1e9, 1e9);
+        if (pos.x == -2) break;
+    }
+    return NULL;
+}
+
+/**
+ * Solves a helper's root position: proves the outcome, then finds the
+ * exact score if there are few enough empties. Results only land in the
+ * transposition table.
+ *
+ * @param helper the helper (or ponder thread)
+ */
+void team03_solveHelper(team03_helper_t *helper) {
+    int empties = 64 - team03_popcount(helper->state.on);
+    solvePair_t res = team03_solveEndgameRoot(helper->state, helper->color, helper->moveList, helper->num, -1, 1);
+    if (res.pos.x != -2 && res.score != 0 && empties <= TEAM03_ENDGAME_EMPTIES)
+        team03_solveEndgameRoot(helper->state, helper->color, helper->moveList, helper->num,
+                                (res.score > 0) ? 0 : -65, (res.score > 0) ? 65 : 0);
+}
+
+
+/*
+ **********************
+ * YBWC               *
+ **********************
+ */
+
+/**
+ * Checks whether a node at the given depth should be split between
+ * threads under the YBWC backend.
+ *
+ * @param layer the node's remaining depth
+ *
+ * @return 1 if the node's younger brothers should be shared; otherwise 0
+ */
+int team03_canSplit(int layer) {
+    return team03_parallel == TEAM03_PARALLEL_YBWC && team03_numThreads > 1
+           && layer >= TEAM03_YBWC_MIN_LAYER;
+}
+
+/**
+ * Checks whether an endgame solver node with the given number of empties
+ * should be split between threads under the YBWC backend.
+ *
+ * @param empties the node's number of empty squares
+ *
+ * @return 1 if the node's younger brothers should be shared; otherwise 0
+ */
+int team03_canSplitEndgame(int empties) {
+    return team03_parallel == TEAM03_PARALLEL_YBWC && team03_numThreads > 1
+           && empties >= TEAM03_YBWC_MIN_EMPTIES;
+}
+
+/**
+ * Searches the remaining moves of a node in parallel. The node becomes a
+ * split point on this thread's deque; idle threads steal moves from it
+ * while this thread works through them too. A beta cutoff aborts every
+ * move still being searched below the split point. Each move's score is
+ * written back to `pairs` (a bound, outside the window it was given).
+ *
+ * @param state the node's board state
+ * @param color the color to move
+ * @param layer the node's remaining depth, or its empties in the endgame
+ * @param alpha the node's alpha; updated with the result
+ * @param beta the node's beta
+ * @param best the node's best score so far; updated with the result
+ * @param bestPos the node's best move so far; updated with the result
+ * @param pairs the node's moves; the first has already been searched
+ * @param num the number of moves
+ * @param endgame 1 if the moves are to be solved exactly (scores in discs)
+ *
+ * @return 0 if all moves were searched, 1 on a beta cutoff, or -1 if we
+ * ran out of time or a split point above us was aborted
+ */
+int team03_split(board_t state, int color, int layer, int *alpha, int beta,
+                 int *best, pos_t *bestPos, solvePair_t *pairs, int num, int endgame) {
+    // Set up the split point with the eldest brother's result
+    team03_split_t sp;
+    sp.parent = team03_curSplit;
+    TEAM03_LOCK_INIT(&sp.lock);
+    sp.state = state, sp.color = color, sp.layer = layer, sp.endgame = endgame;
+    sp.alpha = *alpha, sp.beta = beta, sp.best = *best, sp.bestPos = *bestPos;
+    sp.moves = pairs, sp.num = num, sp.next = 1;
+    sp.workers = 0, sp.abort = 0, sp.cutoff = 0, sp.incomplete = 0;
+    
+    // Publish it on our deque; the deque is bounded by the search depth
+    team03_deque_t *deque = &team03_deques[team03_threadId];
+    TEAM03_LOCK(&deque->lock);
+    int published = deque->size < 64;
+    if (published) deque->items[deque->size++] = &sp;
+    TEAM03_UNLOCK(&deque->lock);
+    
+    // Work through the moves ourselves until they're all handed out
+    team03_splitWork(&sp);
+    
+    // Unpublish it so nobody new can join, then wait for the thieves,
+    // helping with any work split off below this split point meanwhile.
+    // The count is read under the lock, so the last thief is out of its
+    // unlock before we destroy the lock and the split point goes away
+    TEAM03_LOCK(&deque->lock);
+    if (published) deque->size--;
+    TEAM03_UNLOCK(&deque->lock);
+    for (;;) {
+        TEAM03_LOCK(&sp.lock);
+        int workers = sp.workers;
+        TEAM03_UNLOCK(&sp.lock);
+        if (!workers) break;
+        if (!team03_steal(&sp)) team03_yield();
+    }
+    TEAM03_LOCK_DESTROY(&sp.lock);
+    
+    // Report the result back to the node
+    *alpha = sp.alpha, *best = sp.best, *bestPos = sp.bestPos;
+    if (sp.cutoff) return 1;
+    return sp.incomplete ? -1 : 0;
+}
+
+/**
+ * Claims and searches moves from a split point until there are none
+ * left or it's aborted.
+ *
+ * @param sp the split point
+ */
+void team03_splitWork(team03_split_t *sp) {
+    team03_split_t *prev = team03_curSplit;
+    team03_curSplit = sp;
+    
+    TEAM03_LOCK(&sp->lock);
+    while (sp->next < sp->num && !team03_splitAborted(sp)) {
+        // Claim the next move with the current window
+        int index = sp->next++;
+        pos_t pos = sp->moves[index].pos;
+        int alpha = sp->alpha, beta = sp->beta;
+        TEAM03_UNLOCK(&sp->lock);
+        
+        board_t cur = team03_executeMove(sp->state, pos, sp->color);
+        solvePair_t oppSolve = sp->endgame ? team03_solveSplitChild(cur, !sp->color, sp->layer - 1, alpha, beta)
+                                           : team03_searchChild(cur, !sp->color, sp->layer - 1, alpha, beta, 0);
+        
+        // Merge the result into the split point
+        TEAM03_LOCK(&sp->lock);
+        if (oppSolve.pos.x == -2) {
+            sp->incomplete = 1;
+            continue;
+        }
+        int score = 0 - oppSolve.score;
+        sp->moves[index].score = score;
+        if (score > sp->best) sp->best = score, sp->bestPos = pos;
+        if (score > sp->alpha) sp->alpha = score;
+        if (sp->alpha >= sp->beta) sp->cutoff = 1, sp->abort = 1;
+    }
+    TEAM03_UNLOCK(&sp->lock);
+    
+    team03_curSplit = prev;
+}
+
+/**
+ * Solves a move handed out from an endgame split point, with solver
+ * state of its own: a null window first, as a younger brother, then the
+ * full window if the score lands inside it.
+ *
+ * @param child the board after the move
+ * @param color the color to move in the child
+ * @param empties the child's number of empty squares
+ * @param alpha the split point's alpha
+ * @param beta the split point's beta
+ *
+ * @return the child's result, as from `team03_solveEndgame`
+ */
+solvePair_t team03_solveSplitChild(board_t child, int color, int empties, int alpha, int beta) {
+    team03_endgame_t eg;
+    int parity = team03_initEmpties(&eg, child);
+    solvePair_t res = team03_solveEndgame(&eg, child, color, -alpha - 1, -alpha, empties, parity, 0);
+    if (res.pos.x != -2 && -res.score > alpha && -res.score < beta)
+        res = team03_solveEndgame(&eg, child, color, -beta, -alpha, empties, parity, 0);
+    team03_nodeStats[team03_threadId].nodes += eg.nodes;
+    return res;
+}
+
+/**
+ * Tries to steal work: scans the other threads' deques, oldest (largest)
+ * split points first, and joins the first one with moves left.
+ *
+ * @param ancestor if not NULL, only split points below this one qualify
+ * (used by a split point's owner while it waits for thieves)
+ *
+ * @return 1 if we found and did some work; otherwise 0
+ */
+int team03_steal(team03_split_t *ancestor) {
+    for (int i = 0; i < team03_numThreads; i++) {
+        int victim = (team03_threadId + 1 + i) % team03_numThreads;
+        team03_deque_t *deque = &team03_deques[victim];
+        team03_split_t *sp = NULL;
+        
+        // Register as a worker while holding the deque lock, so the owner
+        // can't unpublish (and free) the split point under us
+        TEAM03_LOCK(&deque->lock);
+        for (int j = 0; j < deque->size && !sp; j++) {
+            team03_split_t *cand = deque->items[j];
+            if (ancestor && !team03_splitDescends(cand, ancestor)) continue;
+            
+            TEAM03_LOCK(&cand->lock);
+            if (cand->next < cand->num && !team03_splitAborted(cand)) {
+                cand->workers++;
+                sp = cand;
+            }
+            TEAM03_UNLOCK(&cand->lock);
+        }
+        TEAM03_UNLOCK(&deque->lock);
+        if (!sp) continue;
+        
+        // Work on it, then sign off
+        team03_splitWork(sp);
+        TEAM03_LOCK(&sp->lock);
+        sp->workers--;
+        TEAM03_UNLOCK(&sp->lock);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Checks whether a split point or any split point above it was aborted.
+ *
+ * @param sp the innermost split point, or NULL
+ *
+ * @return 1 if the search below `sp` should unwind; otherwise 0
+ */
+int team03_splitAborted(team03_split_t *sp) {
+    for (; sp; sp = sp->parent) if (sp->abort) return 1;
+    return 0;
+}
+
+/**
+ * Checks whether a split point lies below another one.
+ *
+ * @param sp the split point to check
+ * @param ancestor the possible ancestor
+ *
+ * @return 1 if `ancestor` is on `sp`'s parent chain; otherwise 0
+ */
+int team03_splitDescends(team03_split_t *sp, team03_split_t *ancestor) {
+    for (sp = sp->parent; sp; sp = sp->parent) if (sp == ancestor) return 1;
+    return 0;
+}
+
+/**
+ * Gives up the rest of this thread's time slice while it waits for work.
+ */
+void team03_yield(void) {
+#ifdef TEAM03_IS_POSIX
+    sched_yield();
+#endif
+}
+
+/**
+ * Prints how much faster the current parallel backend searches the given
+ * position to a fixed depth with 1, 2, 4, 8 and 16 threads than with one.
+ * Positions with TEAM03_ENDGAME_EMPTIES or fewer empties are solved
+ * exactly instead, with the helpers doing what they do in a game. The
+ * transposition table is cleared before each run, and the scores are
+ * printed so differences in the result can be spotted, along with the
+ * share of cutoffs caused by the first move searched.
+ *
+ * @param state the position to search
+ * @param color the color to move
+ * @param layers the depth to search to (with iterative deepening); not
+ * used for endgame positions
+ * @param out the stream to print the report to
+ */
+void team03_reportSpeedup(board_t state, int color, int layers, FILE *out) {
+    team03_init();
+    int savedThreads = team03_numThreads;
+    long long savedMaxTime = team03_maxTime;
+    long long base = 0;
+    int empties = 64 - team03_popcount(state.on), endgame = empties <= TEAM03_ENDGAME_EMPTIES;
+    
+    const char *backend = team03_parallel == TEAM03_PARALLEL_YBWC ? "YBWC" : "Lazy SMP";
+    if (endgame) fprintf(out, "%s, exact solve of %d empties\n", backend, empties);
+    else fprintf(out, "%s, depth %d\n", backend, layers);
+    fprintf(out, "threads  time (ms)  speedup  1st-cut  score  move\n");
+    for (int threads = 1; threads <= 16; threads *= 2) {
+        team03_numThreads = threads;
+        team03_maxTime = 1ll << 40;
+        team03_deadline = TEAM03_NO_DEADLINE;
+        TEAM03_STORE(team03_stop, 0);
+        team03_ttClear();
+        memset(team03_orderStats, 0, sizeof(team03_orderStats));
+        
+        // Same iterative deepening as `team03_iterate`, but to a fixed depth
+        solvePair_t moveList[64];
+        int num = team03_getMoves(state, color, moveList, 1);
+        gettimeofday(&team03_startTime, 0);
+        team03_startHelpers(state, color, moveList, num, endgame);
+        pos_t pos = moveList[0].pos;
+        int score = 0;
+        if (endgame) {
+            solvePair_t res = team03_solveEndgameRoot(state, color, moveList, num, -65, 65);
+            pos = res.pos, score = res.score;
+        } else {
+            int scores[TEAM03_MAX_LAYERS + 1];
+            for (int i = 1; i <= layers; i++) {
+                pos = team03_aspirate(state, color, moveList, num, i, (i > 2) ? scores[i - 2] : 0, &pos);
+                scores[i] = moveList[0].score;
+            }
+            score = moveList[0].score;
+        }
+        team03_stopHelpers();
+        long long took = team03_timeSinceMs(team03_startTime);
+        
+        // The solver doesn't keep cutoff stats, so there's no rate to show
+        char cutoffs[16] = "-";
+        if (!endgame) snprintf(cutoffs, sizeof(cutoffs), "%.1f%%", 100.0 * team03_firstCutoffRate());
+        if (threads == 1) base = took;
+        fprintf(out, "%7d  %9lld  %7.2f  %7s  %5d  (%d, %d)\n", threads, took,
+                took ? (double) base / took : 0.0, cutoffs, score, pos.y, pos.x);
+    }
+    
+    team03_numThreads = savedThreads;
+    team03_maxTime = savedMaxTime;
+}
+
+
+/*
+ **********************
+ * Transposition table*
+ **********************
+ */
+
+/**
+ * (Re)allocates the transposition table with the given size, rounded
+ * down to a power-of-two number of buckets, and clears it. Sizes are
+ * clamped to TEAM03_HASH_MAX_MB; if the allocation fails, the size is
+ * halved until it succeeds, and the process exits (status 1) if not even
+ * a single bucket can be allocated.
+ *
+ * @param megabytes the table size in MB
+ */
+void team03_ttResize(size_t megabytes) {
+    // Round down to a power of two so we can mask instead of mod
+    if (megabytes < 1) megabytes = 1;
+    if (megabytes > TEAM03_HASH_MAX_MB) megabytes = TEAM03_HASH_MAX_MB;
+    if (megabytes > ((size_t) -1 >> 21)) megabytes = (size_t) -1 >> 21; // 32-bit
+    size_t buckets = 1, bytes = megabytes << 20;
+    while (buckets <= bytes / (2 * sizeof(team03_ttBucket_t))) buckets *= 2;
+    
+    // Allocate with room to align the buckets to cache lines, halving the
+    // size until it fits
+    size_t wanted = buckets;
+    free(team03_ttMemory);
+    while (!(team03_ttMemory = calloc(buckets * sizeof(team03_ttBucket_t) + 63, 1))) {
+        if (buckets == 1) {
+            fprintf(stderr, "team03: couldn't allocate the transposition table\n");
+            exit(1);
+        }
+        buckets /= 2;
+    }
+    if (buckets < wanted)
+        fprintf(stderr, "team03: transposition table shrunk to %lu KB\n",
+                (unsigned long) (buckets * sizeof(team03_ttBucket_t) >> 10));
+    team03_tt = (team03_ttBucket_t *) (((size_t) team03_ttMemory + 63) & ~(size_t) 63);
+    team03_ttMask = buckets - 1;
+}
+
+/**
+ * Clears every entry in the transposition table.
+ */
+void team03_ttClear(void) {
+    memset(team03_tt, 0, (team03_ttMask + 1) * sizeof(team03_ttBucket_t));
+}
+
+/**
+ * Starts a new search (move) by aging the table, so entries from earlier
+ * moves are replaced first but can still be hit.
+ */
+void team03_ttNewSearch(void) {
+    team03_ttAge++;
+}
+
+/**
+ * Looks up the given key in the transposition table.
+ *
+ * @param key the position key (see `team03_hashKey`)
+ * @param out where to unpack the entry, if found
+ *
+ * @return 1 if the key was found; otherwise 0
+ */
+int team03_ttProbe(uint64_t key, team03_ttData_t *out) {
+    team03_ttBucket_t *bucket = &team03_tt[key & team03_ttMask];
+    team03_nodeStats_t *counts = &team03_nodeStats[team03_threadId];
+    counts->ttProbes++;
+    for (int i = 0; i < 4; i++) {
+        // Entries store key ^ data, so an entry torn by another thread's
+        // concurrent write fails the check instead of returning junk
+        team03_ttEntry_t entry = bucket->entries[i];
+        if ((entry.key ^ entry.data) != key || !entry.data) continue;
+        
+        // Unpack the data word
+        out->score = (int) (uint32_t) entry.data;
+        out->depth = (int8_t) (entry.data >> 32);
+        out->bound = (entry.data >> 40) & 3;
+        out->move = (int8_t) ((entry.data >> 42) & 127) - 1;
+        out->age = (uint8_t) (entry.data >> 49);
+        counts->ttHits++;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Stores a search result in the transposition table, replacing the
+ * same position's entry or else the oldest/shallowest one in its bucket.
+ *
+ * @param key the position key (see `team03_hashKey`)
+ * @param score the score found
+ * @param depth the depth (layers) searched
+ * @param bound TEAM03_TT_EXACT, TEAM03_TT_LOWER or TEAM03_TT_UPPER
+ * @param move the bit index of the best move, or -1 if none
+ */
+void team03_ttStore(uint64_t key, int score, int depth, int bound, int move) {
+    team03_ttBucket_t *bucket = &team03_tt[key & team03_ttMask];
+    team03_ttEntry_t *victim = &bucket->entries[0];
+    int victimValue = 1 << 30;
+    
+    for (int i = 0; i < 4; i++) {
+        team03_ttEntry_t *entry = &bucket->entries[i];
+        
+        // Always overwrite the same position (or an empty slot)
+        if ((entry->key ^ entry->data) == key || !entry->data) {
+            victim = entry;
+            break;
+        }
+        
+        // Otherwise prefer replacing old, then shallow entries
+        uint8_t age = (uint8_t) (entry->data >> 49);
+        int value = (int8_t) (entry->data >> 32) - ((uint8_t) (team03_ttAge - age)) * 16;
+        if (value < victimValue) victim = entry, victimValue = value;
+    }
+    
+    // Pack the data word; the move is stored +1 so "none" is 0
+    uint64_t data = (uint64_t) (uint32_t) score
+                    | (uint64_t) (uint8_t) depth << 32
+                    | (uint64_t) bound << 40
+                    | (uint64_t) (move + 1) << 42
+                    | (uint64_t) team03_ttAge << 49;
+    victim->data = data;
+    victim->key = key ^ data;
+}
+
+/**
+ * Fills the Zobrist key tables from a fixed seed.
+ */
+void team03_initZobrist(void) {
+    // splitmix64; any decent fixed sequence will do
+    uint64_t seed = 0x0305a3c1b2d4e6f7ull;
+    for (int i = 0; i < 130; i++) {
+        uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        z ^= z >> 31;
+        
+        if (i < 128) team03_zobrist[i >> 6][i & 63] = z;
+        else if (i == 128) team03_zobristSide = z;
+        else team03_zobristEndgame = z;
     }
-    
-    // Return the best move we found
-    solvePair_t pair = team03_makeSolvePair(bestPos, best);
-    return pair;
+    for (int i = 0; i < 64; i++)
+        team03_zobristFlip[i] = team03_zobrist[0][i] ^ team03_zobrist[1][i];
 }
 
 /**
- * Statically evaluates all of color's moves for the current board
- * state, outputting a list pairing move positions with their static
- * scores in descending order of value.
- * <br/><br/>
- * If evaluate is 0, instead just gets the moves that are valid.
+ * Computes the Zobrist hash of the pieces on the board from scratch.
  *
- * @param state the current board state
- * @param color the color to check moves for
- * @param arr a pointer to an array solvePair_t[64]
- * @param evaluate whether to evaluate and sort the move list before returning
- * 
- * @return the result array size, or -1 if any move score was found outside of [min, max]
+ * @param state the board state
+ *
+ * @return the hash
  */
-int team03_getMoves(board_t state, int color, solvePair_t *arr, int evaluate) {
-    // # of valid moves we've found
-    int num = 0;
-    
-    // Loop over all cell positions
-    pos_t pos = team03_makePos(0, 0);
-    for (; pos.y < 8; pos.y++) {
-        for (pos.x = 0; pos.x < 8; pos.x++) {
-            // Execute this move; skip if its invalid
-            board_t cur = team03_executeMove(state, pos, color);
-            if (team03_boardEquals(state, cur)) continue;
-            
-            // Compute the score for this move
-            int score = evaluate ? team03_evaluateStatic(state, color) : 0;
-            arr[num++] = team03_makeSolvePair(pos, score);
-        }
+uint64_t team03_hashBoard(board_t state) {
+    uint64_t hash = 0;
+    for (uint64_t on = state.on; on; on &= on - 1) {
+        int8_t ind = team03_bitScan(on);
+        hash ^= team03_zobrist[team03_getBit(state.color, ind)][ind];
     }
-    
-    // Sort the output array
-    if (num > 0 && evaluate) team03_sort(arr, 0, num - 1);
-    return num;
+    return hash;
+}
+
+/**
+ * Gets the transposition table key for a position: the board hash with
+ * the side to move mixed in.
+ *
+ * @param state the board state
+ * @param color the color to move
+ *
+ * @return the key
+ */
+uint64_t team03_hashKey(board_t state, int color) {
+    return state.hash ^ (team03_zobristSide & (0 - (uint64_t) color));
 }
 
 
@@ -514,7 +3132,7 @@ int team03_getMoves(board_t state, int color, solvePair_t *arr, int evaluate) {
 board_t team03_loadBoard(const enum piece board[][SIZE]) {
     // Initialize an empty board
     board_t res;
-    res.on = res.color = 0;
+    res.on = res.color = res.hash = 0;
     
     // Iterate over board positions
     for (int8_t i = 0; i < 8; i++) {
@@ -530,7 +3148,8 @@ board_t team03_loadBoard(const enum piece board[][SIZE]) {
         }
     }
     
-    // Return the translated board state
+    // Hash the pieces and return the translated board state
+    res.hash = team03_hashBoard(res);
     return res;
 }
 
@@ -638,6 +3257,12 @@ int team03_getColor(board_t state, pos_t pos) {
  */
 void team03_setPiece(board_t *state, pos_t pos, int color) {
     int8_t ind = team03_getIndexByPos(pos);
+    
+    // Hash out the old piece (if any) and hash in the new one
+    if (team03_getBit(state->on, ind))
+        state->hash ^= team03_zobrist[team03_getBit(state->color, ind)][ind];
+    state->hash ^= team03_zobrist[color != 0][ind];
+    
     team03_setBit(&state->on, ind, 1);
     team03_setBit(&state->color, ind, color);
 }
@@ -732,64 +3357,18 @@ int8_t team03_getIndexByPos(pos_t pos) {
 }
 
 /**
- * Computes a bitmask for the move between start and end, inclusive.
- * Assumes they are on the same horizontal, vertical or diagonal axis.
+ * Gets the position for the given flat bit index.
  *
- * @param start the start position of the range
- * @param end the end position of the range
+ * @param ind the bit index, in [0, 63]
  *
- * @return a mask with the bits in the described range asserted
+ * @return the position (row/col) of that bit
  */
-uint64_t team03_getMoveMask(pos_t start, pos_t end) {
-    // Smaller index first for ease of use
-    if (start.y > end.y || (start.y == end.y && start.x > end.x)) {
-        pos_t tmp = start;
-        start = end, end = tmp;
-    }
-    
-    // Convert positions to bit indices
-    int8_t u = team03_getIndexByPos(start);
-    int8_t v = team03_getIndexByPos(end);
-    
-    // Horizontal range
-    if (start.y == end.y) {
-        // All the bits we need to flip are contiguous
-        return team03_rangeMask(u, v);
-    }
-    
-    // Vertical range
-    if (start.x == end.x) {
-        // Mask with all bits in the target column
-        uint64_t mask = 0x0101010101010101ull << start.x;
-        return mask & team03_rangeMask(u, v); // restrict the flipped range
-    }
-    
-    // Diagonal range
-    
-    // Main diagonal template masks
-    const uint64_t main = 0x8040201008040201ull; // southeast
-    const uint64_t anti = 0x0102040810204080ull; // northeast
-    
-    // Aligned with the main diagonal
-    if (start.x < end.x) {
-        // Shift the main diagonal
-        signed dif = (signed) start.y - start.x;
-        uint64_t mask = (dif >= 0) ? (main >> dif) : (main << -dif);
-        
-        // Restrict the range
-        return mask & team03_rangeMask(u, v);
-    }
-    
-    // Aligned with the anti-diagonal
-    // Shift the template mask
-    signed dif = (signed) start.x + start.y - 7;
-    uint64_t mask = (dif >= 0) ? (anti << dif) : (anti >> -dif);
-    
-    // Restrict the range
-    return mask & team03_rangeMask(u, v);
+pos_t team03_getPosByIndex(int8_t ind) {
+    return team03_makePos(ind >> 3, ind & 7);
 }
 
 
+
 /*
  **********************
  * Game logic         *
@@ -797,9 +3376,8 @@ uint64_t team03_getMoveMask(pos_t start, pos_t end) {
  */
 
 /**
- * Checks if the described move is valid. Implementation is identical
- * to `executeMove` except that we break early if any one of the
- * directions we're looking in is a valid flip.
+ * Checks if the described move is valid, i.e. the cell is empty and
+ * playing there would flip at least one piece.
  *
  * @param state the current board state
  * @param pos the position to try playing at
@@ -808,32 +3386,97 @@ uint64_t team03_getMoveMask(pos_t start, pos_t end) {
 int team03_isValidMove(board_t state, pos_t pos, int color) {
     // If the cell is nonempty, we can't place here
     if (team03_hasPiece(state, pos)) return 0;
+    return team03_computeFlips(state, team03_getIndexByPos(pos), color) != 0;
+}
+
+/**
+ * Computes a mask of every cell the given color can legally play at,
+ * using the move generator picked for this CPU.
+ *
+ * @param state the current board state
+ * @param color the color (0/1) to find moves for
+ *
+ * @return a mask with the bit of every legal move asserted
+ */
+uint64_t team03_getLegalMoves(board_t state, int color) {
+    return team03_legalMovesKernel(state, color);
+}
+
+/**
+ * Scalar legal move generator; computes a mask of every cell the given
+ * color can legally play at. Each of the 8 directions is handled with a
+ * Kogge-Stone (parallel prefix) occluded fill, so the whole board is
+ * done in a fixed number of shifts and masks instead of walking rays
+ * cell by cell.
+ *
+ * @param state the current board state
+ * @param color the color (0/1) to find moves for
+ *
+ * @return a mask with the bit of every legal move asserted
+ */
+uint64_t team03_getLegalMovesScalar(board_t state, int color) {
+    uint64_t own = team03_getPieces(state, color);
+    uint64_t opp = team03_getPieces(state, !color);
+    uint64_t empty = ~state.on;
     
-    // Directions to check for flip ranges over
-    const pos_t dirs[] = {
-            {-1, -1},
-            {-1, 0},
-            {-1, 1},
-            {0,  -1},
-            {0,  1},
-            {1,  -1},
-            {1,  0},
-            {1,  1}
-    };
+    // Opponent pieces a run may pass through, with the wrapping file cut
+    // out for the horizontal and diagonal directions
+    uint64_t oppH = opp & TEAM03_NOT_A_FILE & TEAM03_NOT_H_FILE;
     
-    // Try all directions
-    for (int i = 0; i < 8; i++) {
-        // Flip the range in this direction, if it's valid
-        pos_t dir = dirs[i];
-        board_t cur = state;
-        team03_executeMovePartial(&cur, pos, color, dir.y, dir.x);
-        
-        // If the state was modified, we did a flip => this move is valid
-        if (!team03_boardEquals(state, cur)) return 1;
-    }
+    // Left shifts go east/south, right shifts go west/north
+    uint64_t res = 0;
+    res |= team03_fillLeft(own, opp & TEAM03_NOT_A_FILE, 1) << 1 & TEAM03_NOT_A_FILE; // east
+    res |= team03_fillRight(own, opp & TEAM03_NOT_H_FILE, 1) >> 1 & TEAM03_NOT_H_FILE; // west
+    res |= team03_fillLeft(own, opp, 8) << 8; // south
+    res |= team03_fillRight(own, opp, 8) >> 8; // north
+    res |= team03_fillLeft(own, oppH, 9) << 9 & TEAM03_NOT_A_FILE; // southeast
+    res |= team03_fillLeft(own, oppH, 7) << 7 & TEAM03_NOT_H_FILE; // southwest
+    res |= team03_fillRight(own, oppH, 7) >> 7 & TEAM03_NOT_A_FILE; // northeast
+    res |= team03_fillRight(own, oppH, 9) >> 9 & TEAM03_NOT_H_FILE; // northwest
     
-    // If we didn't make any flips, the move is invalid
-    return 0;
+    // Moves can only be played in empty cells
+    return res & empty;
+}
+
+/**
+ * Fills from the given pieces through contiguous runs of propagator bits
+ * towards higher bit indices, in log2(7) doubling steps. Only runs of
+ * length >= 1 are kept, so shifting the result by `shift` once more
+ * gives every cell that caps a run.
+ *
+ * @param gen the generator pieces (the mover's pieces)
+ * @param pro the propagator (opponent pieces, wrap-masked)
+ * @param shift the direction's shift amount (1, 7, 8 or 9)
+ *
+ * @return the cells of every run reachable from a generator
+ */
+uint64_t team03_fillLeft(uint64_t gen, uint64_t pro, int shift) {
+    gen = pro & (gen << shift);
+    gen |= pro & (gen << shift);
+    pro &= pro << shift;
+    gen |= pro & (gen << (shift * 2));
+    pro &= pro << (shift * 2);
+    gen |= pro & (gen << (shift * 4));
+    return gen;
+}
+
+/**
+ * Same as `team03_fillLeft`, but towards lower bit indices.
+ *
+ * @param gen the generator pieces (the mover's pieces)
+ * @param pro the propagator (opponent pieces, wrap-masked)
+ * @param shift the direction's shift amount (1, 7, 8 or 9)
+ *
+ * @return the cells of every run reachable from a generator
+ */
+uint64_t team03_fillRight(uint64_t gen, uint64_t pro, int shift) {
+    gen = pro & (gen >> shift);
+    gen |= pro & (gen >> shift);
+    pro &= pro >> shift;
+    gen |= pro & (gen >> (shift * 2));
+    pro &= pro >> (shift * 2);
+    gen |= pro & (gen >> (shift * 4));
+    return gen;
 }
 
 /**
@@ -849,92 +3492,342 @@ int team03_isValidMove(board_t state, pos_t pos, int color) {
  */
 board_t team03_executeMove(board_t state, pos_t pos, int color) {
     // If the cell is nonempty, we can't place here
-    if (team03_hasPiece(state, pos)) return state;
-    
-    // Directions to check for flip ranges over
-    const pos_t dirs[] = {
-            {-1, -1},
-            {-1, 0},
-            {-1, 1},
-            {0,  -1},
-            {0,  1},
-            {1,  -1},
-            {1,  0},
-            {1,  1}
-    };
+    int8_t ind = team03_getIndexByPos(pos);
+    if (team03_getBit(state.on, ind)) return state;
     
-    // Try all directions
-    for (int i = 0; i < 8; i++) {
-        // Flip the range in this direction, if it's valid
-        pos_t dir = dirs[i];
-        team03_executeMovePartial(&state, pos, color, dir.y, dir.x);
-    }
+    // If we don't flip anything the move is invalid; state is unmodified
+    uint64_t flips = team03_computeFlips(state, ind, color);
+    if (!flips) return state;
     
-    // If we didn't make any moves, the state is unmodified
+    // Place the piece (with its color) and flip the captured runs
+    uint64_t bit = 1ull << ind;
+    state.on |= bit;
+    state.color = (state.color & ~bit) ^ (flips | (bit & (0 - (uint64_t) color)));
+    
+    // Update the hash for the placed piece and each flipped one
+    state.hash ^= team03_zobrist[color][ind];
+    for (; flips; flips &= flips - 1)
+        state.hash ^= team03_zobristFlip[team03_bitScan(flips)];
     return state;
 }
 
 /**
- * Executes part of a move in the given direction. If there is a valid
- * range that would be flipped by this move, modifies the board state
- * to reflect that change.
+ * Computes the mask of opponent pieces that would be flipped by the
+ * described move, using the flip kernel picked for this CPU.
+ * <br/><br/>
+ * Assumes the move cell is empty; returns 0 if the move is invalid.
  *
- * @param state the board state to (maybe) update
- * @param start the position of the move
- * @param color the color being played
- * @param dy row/y component of the direction for this partial move
- * @param dy column/x component of the direction for this partial move
+ * @param state the current board state
+ * @param ind the bit index of the move cell
+ * @param color the color (0/1) of the piece to place
+ *
+ * @return the mask of pieces flipped by the move
  */
-void team03_executeMovePartial(board_t *state, pos_t start, int color, int8_t dy, int8_t dx) {
-    // Loop over the run we're looking at
-    pos_t end = team03_makePos(start.y + dy, start.x + dx);
-    for (; team03_inBounds(end); end.y += dy, end.x += dx) {
-        int piece = team03_getPiece(*state, end);
-        if (piece == !color) continue; // if the opponent has a piece here, keep going
-        
-        // If the cell is empty and |run| > 1, flip this range
-        if (piece == color && (end.y != start.y + dy || end.x != start.x + dx)) {
-            team03_setPieces(state, start, end, color);
-        }
+uint64_t team03_computeFlips(board_t state, int8_t ind, int color) {
+    return team03_flipsKernel(state, ind, color);
+}
+
+/**
+ * Scalar flip kernel; computes the mask of opponent pieces that would
+ * be flipped by the described move. Each direction looks up the ray
+ * from the move cell, finds the first cell that isn't an opponent piece
+ * and keeps the run before it only if that cell is one of ours.
+ * <br/><br/>
+ * Assumes the move cell is empty; returns 0 if the move is invalid.
+ *
+ * @param state the current board state
+ * @param ind the bit index of the move cell
+ * @param color the color (0/1) of the piece to place
+ *
+ * @return the mask of pieces flipped by the move
+ */
+uint64_t team03_computeFlipsScalar(board_t state, int8_t ind, int color) {
+    uint64_t own = team03_getPieces(state, color);
+    uint64_t notOpp = own | ~state.on; // anything that ends a run
+    const uint64_t *rays = team03_rays[ind];
+    uint64_t flips = 0;
+    
+    // Rays towards higher indices (E, SW, S, SE): the run ends at the
+    // lowest non-opponent bit on the ray
+    for (int d = 0; d < 4; d++) {
+        uint64_t blockers = rays[d] & notOpp;
+        uint64_t first = blockers & (0 - blockers);
+        uint64_t keep = 0 - (uint64_t) ((first & own) != 0);
+        flips |= (first - 1) & rays[d] & keep;
+    }
+    
+    // Rays towards lower indices (W, NE, N, NW): the run ends at the
+    // highest non-opponent bit. Bit 0 is a sentinel for empty blocker
+    // sets; it's never one of ours on the ray in that case
+    for (int d = 4; d < 8; d++) {
+        uint64_t blockers = rays[d] & notOpp;
+        uint64_t first = 1ull << team03_bitScanReverse(blockers | 1);
+        uint64_t keep = 0 - (uint64_t) ((first & own & rays[d]) != 0);
+        flips |= ~((first << 1) - 1) & rays[d] & keep;
+    }
+    
+    return flips;
+}
+
+#ifdef TEAM03_X86_KERNELS
+/**
+ * BMI2 flip kernel. For each of the 4 lines through the move cell, PEXT
+ * packs the line into an 8-bit index, two small table lookups give the
+ * flipped cells within the line and PDEP scatters them back.
+ * <br/><br/>
+ * Assumes the move cell is empty; returns 0 if the move is invalid.
+ *
+ * @param state the current board state
+ * @param ind the bit index of the move cell
+ * @param color the color (0/1) of the piece to place
+ *
+ * @return the mask of pieces flipped by the move
+ */
+TEAM03_TARGET("bmi2")
+uint64_t team03_computeFlipsPEXT(board_t state, int8_t ind, int color) {
+    uint64_t own = team03_getPieces(state, color);
+    uint64_t opp = team03_getPieces(state, !color);
+    uint64_t flips = 0;
+    
+    for (int l = 0; l < 4; l++) {
+        uint64_t mask = team03_lineMasks[ind][l];
+        int pos = team03_linePos[ind][l];
         
-        // Either we performed a move or the range is invalid
-        return;
+        // Only the 6 inner cells of the line can be flipped
+        int inner = (int) (_pext_u64(opp, mask) >> 1) & 0x3f;
+        int outflank = team03_outflank[pos][inner] & (int) _pext_u64(own, mask);
+        flips |= _pdep_u64(team03_flipped[pos][outflank], mask);
     }
+    
+    return flips;
 }
 
 /**
- * Flips the pieces between the provided start and end positions, inclusive.
- * Assumes all pieces in the range are present.
+ * AVX2 legal move generator. Same Kogge-Stone fill as the scalar version,
+ * but the four direction pairs (E/W, S/N, SW/NE, SE/NW) each get a 64-bit
+ * lane, so one left-shifting and one right-shifting vector cover all 8.
  *
- * @param state the board state to update
- * @param start the start position of the run to flip
- * @param end the end position of the run to flip
+ * @param state the current board state
+ * @param color the color (0/1) to find moves for
+ *
+ * @return a mask with the bit of every legal move asserted
  */
-void team03_flipPieces(board_t *state, pos_t start, pos_t end) {
-    // Compute a mask for the bits between start and end
-    uint64_t mask = team03_getMoveMask(start, end);
-    state->color ^= mask; // flip the bits in range
+TEAM03_TARGET("avx2")
+uint64_t team03_getLegalMovesAVX2(board_t state, int color) {
+    // Moves can only be played in empty cells
+    __m256i own = _mm256_set1_epi64x(team03_getPieces(state, color));
+    __m256i opp = _mm256_set1_epi64x(team03_getPieces(state, !color));
+    return team03_reduceOr(team03_fillMovesAVX2(own, opp)) & ~state.on;
 }
 
 /**
- * Sets the pieces between the provided start and end positions, inclusive,
- * to the desired color. Also places pieces if any cells in range are empty.
+ * The AVX2 move generator's fills: every cell that caps a run of
+ * opponent pieces from one of ours, in each lane's pair of directions.
  *
- * @param state the board state to update
- * @param start the start position of the run to set
- * @param end the end position of the run to set
- * @param color the color to set the pieces to
+ * @param own the mover's pieces, in every lane
+ * @param opp the opponent's pieces, in every lane
+ *
+ * @return each lane's capping cells (empty or not)
+ */
+TEAM03_TARGET("avx2")
+__m256i team03_fillMovesAVX2(__m256i own, __m256i opp) {
+    // Per-lane shift amounts and wrap masks (lanes: E/W, S/N, SW/NE, SE/NW)
+    const __m256i shift = _mm256_set_epi64x(9, 7, 8, 1);
+    const __m256i shift2 = _mm256_add_epi64(shift, shift);
+    const __m256i shift4 = _mm256_add_epi64(shift2, shift2);
+    const __m256i inner = _mm256_set_epi64x(
+            TEAM03_NOT_A_FILE & TEAM03_NOT_H_FILE, TEAM03_NOT_A_FILE & TEAM03_NOT_H_FILE,
+            -1, TEAM03_NOT_A_FILE & TEAM03_NOT_H_FILE);
+    const __m256i wrapL = _mm256_set_epi64x(TEAM03_NOT_A_FILE, TEAM03_NOT_H_FILE, -1, TEAM03_NOT_A_FILE);
+    const __m256i wrapR = _mm256_set_epi64x(TEAM03_NOT_H_FILE, TEAM03_NOT_A_FILE, -1, TEAM03_NOT_H_FILE);
+    __m256i pro = _mm256_and_si256(opp, inner);
+    
+    // Fill towards higher indices (E, S, SW, SE)
+    __m256i pro2 = _mm256_and_si256(pro, _mm256_sllv_epi64(pro, shift));
+    __m256i pro4 = _mm256_and_si256(pro2, _mm256_sllv_epi64(pro2, shift2));
+    __m256i gen = _mm256_and_si256(pro, _mm256_sllv_epi64(own, shift));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, _mm256_sllv_epi64(gen, shift)));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro2, _mm256_sllv_epi64(gen, shift2)));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro4, _mm256_sllv_epi64(gen, shift4)));
+    __m256i res = _mm256_and_si256(wrapL, _mm256_sllv_epi64(gen, shift));
+    
+    // Fill towards lower indices (W, N, NE, NW)
+    pro2 = _mm256_and_si256(pro, _mm256_srlv_epi64(pro, shift));
+    pro4 = _mm256_and_si256(pro2, _mm256_srlv_epi64(pro2, shift2));
+    gen = _mm256_and_si256(pro, _mm256_srlv_epi64(own, shift));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, _mm256_srlv_epi64(gen, shift)));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro2, _mm256_srlv_epi64(gen, shift2)));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro4, _mm256_srlv_epi64(gen, shift4)));
+    return _mm256_or_si256(res, _mm256_and_si256(wrapR, _mm256_srlv_epi64(gen, shift)));
+}
+
+/**
+ * AVX2 flip kernel. Fills from the move cell through opponent pieces in
+ * all 8 directions at once (4 lanes x 2 shift directions) and keeps each
+ * lane's run only if the cell after it is one of ours.
+ * <br/><br/>
+ * Assumes the move cell is empty; returns 0 if the move is invalid.
+ *
+ * @param state the current board state
+ * @param ind the bit index of the move cell
+ * @param color the color (0/1) of the piece to place
+ *
+ * @return the mask of pieces flipped by the move
+ */
+TEAM03_TARGET("avx2")
+uint64_t team03_computeFlipsAVX2(board_t state, int8_t ind, int color) {
+    // Per-lane shift amounts (lanes: E/W, S/N, SW/NE, SE/NW)
+    const __m256i shift = _mm256_set_epi64x(9, 7, 8, 1);
+    const __m256i shift2 = _mm256_add_epi64(shift, shift);
+    const __m256i shift4 = _mm256_add_epi64(shift2, shift2);
+    const __m256i inner = _mm256_set_epi64x(
+            TEAM03_NOT_A_FILE & TEAM03_NOT_H_FILE, TEAM03_NOT_A_FILE & TEAM03_NOT_H_FILE,
+            -1, TEAM03_NOT_A_FILE & TEAM03_NOT_H_FILE);
+    const __m256i zero = _mm256_setzero_si256();
+    
+    // Runs can only go through the opponent's non-edge pieces, so the
+    // fills can't wrap around the board
+    __m256i own = _mm256_set1_epi64x(team03_getPieces(state, color));
+    __m256i pro = _mm256_and_si256(inner, _mm256_set1_epi64x(team03_getPieces(state, !color)));
+    __m256i move = _mm256_set1_epi64x(1ull << ind);
+    
+    // Fill towards higher indices; drop lanes whose run isn't capped
+    __m256i pro2 = _mm256_and_si256(pro, _mm256_sllv_epi64(pro, shift));
+    __m256i pro4 = _mm256_and_si256(pro2, _mm256_sllv_epi64(pro2, shift2));
+    __m256i gen = _mm256_and_si256(pro, _mm256_sllv_epi64(move, shift));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, _mm256_sllv_epi64(gen, shift)));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro2, _mm256_sllv_epi64(gen, shift2)));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro4, _mm256_sllv_epi64(gen, shift4)));
+    __m256i cap = _mm256_and_si256(own, _mm256_sllv_epi64(gen, shift));
+    __m256i res = _mm256_andnot_si256(_mm256_cmpeq_epi64(cap, zero), gen);
+    
+    // Same towards lower indices
+    pro2 = _mm256_and_si256(pro, _mm256_srlv_epi64(pro, shift));
+    pro4 = _mm256_and_si256(pro2, _mm256_srlv_epi64(pro2, shift2));
+    gen = _mm256_and_si256(pro, _mm256_srlv_epi64(move, shift));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, _mm256_srlv_epi64(gen, shift)));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro2, _mm256_srlv_epi64(gen, shift2)));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro4, _mm256_srlv_epi64(gen, shift4)));
+    cap = _mm256_and_si256(own, _mm256_srlv_epi64(gen, shift));
+    res = _mm256_or_si256(res, _mm256_andnot_si256(_mm256_cmpeq_epi64(cap, zero), gen));
+    
+    return team03_reduceOr(res);
+}
+
+/**
+ * ORs together the four 64-bit lanes of a vector.
+ *
+ * @param vec the vector to reduce
+ *
+ * @return the OR of all four lanes
+ */
+TEAM03_TARGET("avx2")
+uint64_t team03_reduceOr(__m256i vec) {
+    __m128i half = _mm_or_si128(_mm256_castsi256_si128(vec), _mm256_extracti128_si256(vec, 1));
+    half = _mm_or_si128(half, _mm_unpackhi_epi64(half, half));
+    return (uint64_t) _mm_cvtsi128_si64(half);
+}
+
+/**
+ * AVX2 mobility kernel; the AVX2 move generator plus a POPCNT.
+ *
+ * @param state the current board state
+ * @param color the color to consider moves for
+ *
+ * @return the number of valid moves that the color can take
+ */
+TEAM03_TARGET("avx2,popcnt")
+int team03_computeMobilityAVX2(board_t state, int color) {
+    return __builtin_popcountll(team03_getLegalMovesAVX2(state, color));
+}
+
+/**
+ * AVX2 mobility advantage kernel. Both sides' fills are independent, so
+ * running them together lets each hide the other's latency.
+ *
+ * @param state the current board state
+ * @param color the color to consider moves for
+ *
+ * @return the difference in the number of valid moves
+ */
+TEAM03_TARGET("avx2,popcnt")
+int team03_computeMobilityDiffAVX2(board_t state, int color) {
+    __m256i own = _mm256_set1_epi64x(team03_getPieces(state, color));
+    __m256i opp = _mm256_set1_epi64x(team03_getPieces(state, !color));
+    uint64_t ours = team03_reduceOr(team03_fillMovesAVX2(own, opp)) & ~state.on;
+    uint64_t theirs = team03_reduceOr(team03_fillMovesAVX2(opp, own)) & ~state.on;
+    return __builtin_popcountll(ours) - __builtin_popcountll(theirs);
+}
+#endif // TEAM03_X86_KERNELS
+
+/**
+ * Fills the per-square direction ray table used by `computeFlips`.
+ */
+void team03_initRays(void) {
+    // Directions, in the same order as the ray table
+    const int8_t dy[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+    const int8_t dx[8] = {1, -1, 0, 1, -1, 1, 0, -1};
+    
+    for (int8_t ind = 0; ind < 64; ind++) {
+        for (int d = 0; d < 8; d++) {
+            // Walk the ray (excluding the start cell) until we leave the board
+            uint64_t ray = 0;
+            pos_t pos = team03_getPosByIndex(ind);
+            for (pos.y += dy[d], pos.x += dx[d]; team03_inBounds(pos);
+                 pos.y += dy[d], pos.x += dx[d])
+                team03_setBitAt(&ray, pos, 1);
+            team03_rays[ind][d] = ray;
+            
+            // The ray's first cell is a neighbour
+            if (ray) team03_neighbours[ind] |= 1ull << ((d < 4) ? team03_bitScan(ray) : team03_bitScanReverse(ray));
+        }
+    }
+}
+
+/**
+ * Fills the line tables used by the PEXT flip kernel.
  */
-void team03_setPieces(board_t *state, pos_t start, pos_t end, int color) {
-    // Compute a mask for the bits between start and end
-    uint64_t mask = team03_getMoveMask(start, end);
+void team03_initLines(void) {
+    // Line masks through each square, and where the square lands in each
+    for (int8_t ind = 0; ind < 64; ind++) {
+        const uint64_t *rays = team03_rays[ind];
+        uint64_t bit = 1ull << ind;
+        team03_lineMasks[ind][0] = rays[0] | rays[4] | bit; // row (E/W)
+        team03_lineMasks[ind][1] = rays[2] | rays[6] | bit; // column (S/N)
+        team03_lineMasks[ind][2] = rays[3] | rays[7] | bit; // diagonal (SE/NW)
+        team03_lineMasks[ind][3] = rays[1] | rays[5] | bit; // anti-diagonal (SW/NE)
+        for (int l = 0; l < 4; l++)
+            team03_linePos[ind][l] = team03_popcount(team03_lineMasks[ind][l] & (bit - 1));
+    }
     
-    // Place pieces where they're missing
-    state->on |= mask;
+    // Diagonals through the top row, then down the left (or right) column
+    for (int i = 0; i < 15; i++) {
+        team03_diagonals[0][i] = team03_lineMasks[(i < 8) ? i : (i - 7) * 8][2];
+        team03_diagonals[1][i] = team03_lineMasks[(i < 8) ? i : (i - 7) * 8 + 7][3];
+    }
     
-    // Set the piece colors
-    if (color) state->color |= mask;
-    else state->color &= ~mask;
+    for (int pos = 0; pos < 8; pos++) {
+        // Candidate outflanking cells: the first non-opponent cell on each
+        // side, if the run of opponent cells before it is non-empty
+        for (int inner = 0; inner < 64; inner++) {
+            int opp = inner << 1, res = 0, q;
+            for (q = pos + 1; q < 7 && (opp >> q & 1); q++);
+            if (q > pos + 1) res |= 1 << q;
+            for (q = pos - 1; q > 0 && (opp >> q & 1); q--);
+            if (q < pos - 1) res |= 1 << q;
+            team03_outflank[pos][inner] = res;
+        }
+        
+        // Flipped cells: everything strictly between pos and each outflank
+        for (int outflank = 0; outflank < 256; outflank++) {
+            int res = 0;
+            for (int q = pos + 1; q < 8; q++)
+                if (outflank >> q & 1) res |= ((1 << q) - 1) & ~((2 << pos) - 1);
+            for (int q = pos - 1; q >= 0; q--)
+                if (outflank >> q & 1) res |= ((1 << pos) - 1) & ~((2 << q) - 1);
+            team03_flipped[pos][outflank] = res;
+        }
+    }
 }
 
 /**
@@ -1041,6 +3934,23 @@ long long team03_timeSinceMs(struct timeval start) {
     return diff_usec / 1000; // convert to ms
 }
 
+/**
+ * Gets the time on a monotonic clock, which (unlike gettimeofday) can't
+ * jump when the system clock is adjusted. Only differences between its
+ * values mean anything.
+ *
+ * @return the current monotonic time in ms
+ */
+long long team03_nowMs(void) {
+#ifdef TEAM03_IS_POSIX
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000ll + now.tv_nsec / 1000000;
+#else
+    return (long long) GetTickCount64();
+#endif
+}
+
 // If we're not on POSIX, we have to provide our own implementation
 // of gettimeofday using windows' FILETIME type
 // https://web.archive.org/web/20100111030931/http://www.cpp-programming.net/c-tidbits/gettimeofday-function-for-windows/
@@ -1153,35 +4063,143 @@ void team03_setBit(uint64_t *mask, int8_t ind, int value) {
 }
 
 /**
- * Creates a mask with a range of bits between `start` and `end` asserted.
+ * Finds the index of the highest set bit in the given integer.
+ * The result is undefined if `num` is 0.
  *
- * @param start the start (from bit 0->) of the range to assert
- * @param offset the (inclusive) end of the range to assert
+ * @param num the integer
  *
- * @return the described mask
+ * @return the index of the highest bit that is on in `num`
+ */
+int team03_bitScanReverse(uint64_t num) {
+#ifdef __has_builtin
+#   if __has_builtin(__builtin_clzll)
+#       define bitscanreverse(x) (63 - __builtin_clzll(x))
+#   endif // has_builtin
+#endif // ifdef
+#ifdef bitscanreverse
+    // GCC's __builtin_clzll is a single bsr/lzcnt instruction
+    return bitscanreverse(num);
+#else
+    // Otherwise halve the search range until we hit the bit
+    int res = 0;
+    if (num >> 32) num >>= 32, res += 32;
+    if (num >> 16) num >>= 16, res += 16;
+    if (num >> 8) num >>= 8, res += 8;
+    if (num >> 4) num >>= 4, res += 4;
+    if (num >> 2) num >>= 2, res += 2;
+    return res + (int) (num >> 1);
+#endif
+}
+
+/**
+ * Finds the index of the lowest set bit in the given integer.
+ * The result is undefined if `num` is 0.
+ *
+ * @param num the integer
+ *
+ * @return the index of the lowest bit that is on in `num`
+ */
+int team03_bitScan(uint64_t num) {
+#ifdef __has_builtin
+#   if __has_builtin(__builtin_ctzll)
+#       define bitscan(x) __builtin_ctzll(x)
+#   endif // has_builtin
+#endif // ifdef
+#ifdef bitscan
+    // GCC's __builtin_ctzll is a single bsf/tzcnt instruction
+    return bitscan(num);
+#else
+    // Otherwise count the bits below the lowest set bit
+    return team03_popcount((num & (0 - num)) - 1);
+#endif
+}
+
+/**
+ * Flips a bitboard vertically (row 0 <-> row 7).
+ *
+ * @param x the bitboard
+ *
+ * @return the flipped bitboard
+ */
+uint64_t team03_flipVertical(uint64_t x) {
+#ifdef __has_builtin
+#   if __has_builtin(__builtin_bswap64)
+#       define byteswap(x) __builtin_bswap64(x)
+#   endif // has_builtin
+#endif // ifdef
+#ifdef byteswap
+    // GCC's __builtin_bswap64 is a single bswap instruction
+    return byteswap(x);
+#else
+    // Otherwise swap bytes, then pairs, then halves
+    x = ((x >> 8) & 0x00ff00ff00ff00ffull) | ((x & 0x00ff00ff00ff00ffull) << 8);
+    x = ((x >> 16) & 0x0000ffff0000ffffull) | ((x & 0x0000ffff0000ffffull) << 16);
+    return (x >> 32) | (x << 32);
+#endif
+}
+
+/**
+ * Mirrors a bitboard horizontally (column 0 <-> column 7).
+ *
+ * @param x the bitboard
+ *
+ * @return the mirrored bitboard
+ */
+uint64_t team03_mirrorHorizontal(uint64_t x) {
+    // Swap bits, then pairs, then nibbles within each byte
+    x = ((x >> 1) & 0x5555555555555555ull) | ((x & 0x5555555555555555ull) << 1);
+    x = ((x >> 2) & 0x3333333333333333ull) | ((x & 0x3333333333333333ull) << 2);
+    return ((x >> 4) & 0x0f0f0f0f0f0f0f0full) | ((x & 0x0f0f0f0f0f0f0f0full) << 4);
+}
+
+/**
+ * Flips a bitboard about its main diagonal (index 0 to 63), swapping rows
+ * and columns.
+ *
+ * @param x the bitboard
+ *
+ * @return the flipped bitboard
  */
-uint64_t team03_rangeMask(int8_t start, int8_t end) {
-    uint64_t mask = 1ull << (end - start);
-    mask <<= 1, mask--;
-    return mask << start;
+uint64_t team03_flipDiagonal(uint64_t x) {
+    // Swap 4x4 blocks, then 2x2 blocks, then single squares
+    // https://www.chessprogramming.org/Flipping_Mirroring_and_Rotating
+    uint64_t t = 0x0f0f0f0f00000000ull & (x ^ (x << 28));
+    x ^= t ^ (t >> 28);
+    t = 0x3333000033330000ull & (x ^ (x << 14));
+    x ^= t ^ (t >> 14);
+    t = 0x5500550055005500ull & (x ^ (x << 7));
+    return x ^ t ^ (t >> 7);
 }
 
 /**
- * Counts the number of set bits in the given integer.
+ * Counts the number of set bits in the given integer, using the popcount
+ * kernel picked for this CPU.
  *
  * @param num the integer
  *
  * @return the number of bits that are on in `num`
  */
 int team03_popcount(uint64_t num) {
+    return team03_popcountKernel(num);
+}
+
+/**
+ * Portable popcount kernel; counts the number of set bits in the given
+ * integer without assuming the POPCNT instruction.
+ *
+ * @param num the integer
+ *
+ * @return the number of bits that are on in `num`
+ */
+int team03_popcountScalar(uint64_t num) {
 #ifdef __has_builtin
 #   if __has_builtin(__builtin_popcountll)
 #       define popcount(x) __builtin_popcountll(x)
 #   endif // has_builtin
 #endif // ifdef
 #ifdef popcount
-    // If GCC's __builtin_popcount is available, we use that as
-    // it's often a single machine-level instruction
+    // If GCC's __builtin_popcount is available, we use that; without a
+    // POPCNT target it's a small table-driven routine in libgcc
     return popcount(num);
 #else
     // Otherwise we do it manually
@@ -1192,6 +4210,57 @@ int team03_popcount(uint64_t num) {
 #endif
 }
 
+#ifdef TEAM03_X86_KERNELS
+/**
+ * POPCNT popcount kernel; a single instruction.
+ *
+ * @param num the integer
+ *
+ * @return the number of bits that are on in `num`
+ */
+TEAM03_TARGET("popcnt")
+int team03_popcountPOPCNT(uint64_t num) {
+    return __builtin_popcountll(num);
+}
+#endif // TEAM03_X86_KERNELS
+
+
+/*
+ **********************
+ * ISA dispatch       *
+ **********************
+ */
+
+/**
+ * Picks the fastest variant of each board kernel that this CPU supports,
+ * from CPUID. Called once at startup by `team03_init`; until then the
+ * scalar kernels are used.
+ */
+void team03_initKernels(void) {
+#ifdef TEAM03_X86_KERNELS
+    __builtin_cpu_init();
+    int hasPopcnt = __builtin_cpu_supports("popcnt");
+    int hasAVX2 = __builtin_cpu_supports("avx2");
+    int hasBMI2 = __builtin_cpu_supports("bmi2");
+    
+    if (hasPopcnt) team03_popcountKernel = team03_popcountPOPCNT;
+    if (hasAVX2) team03_legalMovesKernel = team03_getLegalMovesAVX2;
+    if (hasAVX2 && hasPopcnt) team03_mobilityKernel = team03_computeMobilityAVX2;
+    if (hasAVX2 && hasPopcnt) team03_mobilityDiffKernel = team03_computeMobilityDiffAVX2;
+    if (hasAVX2) team03_patternSumKernel = team03_sumPatternsAVX2;
+    
+    // The AVX2 fills measured fastest, so the PEXT line tables are only
+    // picked on their own when AVX2 is missing
+    int flips = TEAM03_FLIP_BACKEND;
+    if (flips == TEAM03_FLIP_AUTO) {
+        if (hasAVX2) flips = TEAM03_FLIP_AVX2;
+        else if (hasBMI2) flips = TEAM03_FLIP_PEXT;
+    }
+    if (flips == TEAM03_FLIP_PEXT && hasBMI2) team03_flipsKernel = team03_computeFlipsPEXT;
+    if (flips == TEAM03_FLIP_AVX2 && hasAVX2) team03_flipsKernel = team03_computeFlipsAVX2;
+#endif // TEAM03_X86_KERNELS
+}
+
 // Pop our optimization settings
 #ifdef GCC_OPTIM_AVAILABLE
 #   pragma GCC pop_options
@@ -13,16 +13,54 @@
 #   define TEAM03_IS_POSIX
 #endif
 
-// Include the right library for timeval
+// Include the right library for timeval (and threads, on POSIX)
 #ifdef TEAM03_IS_POSIX
 #   include <sys/time.h>
+#   include <pthread.h>
 #else
 #   include <time.h>
 #endif
 
 #include <stdlib.h>
+#include <stdio.h>
 #include "reversi_functions.h"
 
+// Locks and thread-local storage for the parallel search. Without
+// pthreads we only ever run one thread, so the locks are no-ops
+#ifdef TEAM03_IS_POSIX
+typedef pthread_mutex_t team03_lock_t;
+#   define TEAM03_LOCK_INIT(l) pthread_mutex_init(l, NULL)
+#   define TEAM03_LOCK_DESTROY(l) pthread_mutex_destroy(l)
+#   define TEAM03_LOCK(l) pthread_mutex_lock(l)
+#   define TEAM03_UNLOCK(l) pthread_mutex_unlock(l)
+#else
+typedef int team03_lock_t;
+#   define TEAM03_LOCK_INIT(l) ((void) (l))
+#   define TEAM03_LOCK_DESTROY(l) ((void) (l))
+#   define TEAM03_LOCK(l) ((void) (l))
+#   define TEAM03_UNLOCK(l) ((void) (l))
+#endif
+#if defined (_MSC_VER)
+#   define TEAM03_TLS __declspec(thread)
+#   define TEAM03_ALIGN(n) __declspec(align(n))
+#   define TEAM03_LOAD(x) (x)
+#   define TEAM03_STORE(x, v) ((x) = (v))
+#else
+#   define TEAM03_TLS __thread
+#   define TEAM03_ALIGN(n) __attribute__((aligned(n)))
+// Relaxed atomic loads/stores, for flags shared between threads
+#   define TEAM03_LOAD(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#   define TEAM03_STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+#endif
+
+// Check if we can build x86 kernels for ISAs beyond the compile target
+#if (defined (__x86_64__) || defined (__i386__)) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9) || defined (__clang__))
+#   define TEAM03_IS_X86
+#   define TEAM03_TARGET(isa) __attribute__((target(isa)))
+#   include <immintrin.h>
+#endif
+
 // System check
 #if defined (__unix__) || (defined (__APPLE__) && defined (__MACH__))
 #   define TEAM03_IS_POSIX
@@ -45,6 +83,26 @@ typedef unsigned long long uint64_t;
 typedef signed char int8_t;
 #endif // _INT8_T
 
+#ifndef _UINT32_T
+#   define _UINT32_T
+typedef unsigned int uint32_t;
+#endif // _UINT32_T
+
+#ifndef _UINT8_T
+#   define _UINT8_T
+typedef unsigned char uint8_t;
+#endif // _UINT8_T
+
+#ifndef _UINT16_T
+#   define _UINT16_T
+typedef unsigned short uint16_t;
+#endif // _UINT16_T
+
+#ifndef _INT16_T
+#   define _INT16_T
+typedef short int16_t;
+#endif // _INT16_T
+
 
 /*
  **********************
@@ -63,168 +121,1312 @@ typedef signed char int8_t;
  *
  * The second integer stores, for each cell with a piece in it, the color of
  * that cell. The bits at any other (empty) positions are meaningless.
+ *
+ * The third integer is the position's Zobrist hash (pieces only; the side
+ * to move is mixed in by `team03_hashKey`), kept up to date by
+ * `team03_executeMove`.
  * <br/><br/>
  *
  * In theory, this gives us really fast lookups and flips, which should
  * directly correspond with better moves since we can traverse further
  * down the game tree.
  */
-typedef struct board {
-    uint64_t on, color;
-} board_t;
-#endif // BOARD_H
+typedef struct board {
+    uint64_t on, color, hash;
+} board_t;
+#endif // BOARD_H
+
+#ifndef POS_H
+#define POS_H
+/**
+ * Lightweight position struct.
+ * y=row, x=col
+ */
+typedef struct pos {
+    int8_t y, x; // signed to avoid underflow issues in move loops
+} pos_t;
+#endif // POS_H
+
+#ifndef SOLVEPAIR_H
+#define SOLVEPAIR_H
+/**
+ * A solve result to return from move evaluation functions.
+ */
+typedef struct solvePair {
+    pos_t pos;
+    int score;
+} solvePair_t;
+#endif // SOLVEPAIR_H
+
+#ifndef TEAM03_TT_H
+#define TEAM03_TT_H
+/**
+ * A transposition table entry. The data word is packed as
+ * score (32 bits) | depth (8) | bound (2) | move (7) | age (8).
+ * The key word holds the position key XORed with the data word, so
+ * threads can share the table without locks.
+ */
+typedef struct team03_ttEntry {
+    uint64_t key, data;
+} team03_ttEntry_t;
+
+/**
+ * A cache-line sized bucket of transposition table entries; a position
+ * can only be stored in the bucket its hash maps to.
+ */
+typedef struct team03_ttBucket {
+    team03_ttEntry_t entries[4];
+} team03_ttBucket_t;
+
+/**
+ * An unpacked transposition table entry.
+ */
+typedef struct team03_ttData {
+    int score;
+    int8_t depth;
+    uint8_t bound; // one of TEAM03_TT_EXACT/LOWER/UPPER
+    int8_t move; // bit index of the best move, or -1 if none
+    uint8_t age;
+} team03_ttData_t;
+#endif // TEAM03_TT_H
+
+#ifndef TEAM03_ASPSTATS_H
+#define TEAM03_ASPSTATS_H
+/**
+ * How often aspiration searches at one depth had to be repeated.
+ */
+typedef struct team03_aspStats {
+    long long searches; // total root searches, including re-searches
+    long long failLow, failHigh; // re-searches caused by each kind of fail
+} team03_aspStats_t;
+#endif // TEAM03_ASPSTATS_H
+
+#ifndef TEAM03_PICKER_H
+#define TEAM03_PICKER_H
+/**
+ * Hands out an interior node's moves one at a time, best guess first, in
+ * stages (see `team03_nextMove`). A stage's work is only done once every
+ * move from the stages before it has been searched without a cutoff.
+ */
+typedef struct team03_picker {
+    uint64_t moves; // legal moves not handed out yet
+    int stage; // one of TEAM03_PICK_*
+    int color; // the color to move
+    int8_t ttMove; // bit index of the table's move, or -1
+    int8_t killers[2]; // bit indices of this ply's killers, or -1
+    const solvePair_t *list; // moves already ranked, if not NULL
+    int next; // index of the next move in `list`
+} team03_picker_t;
+#endif // TEAM03_PICKER_H
+
+#ifndef TEAM03_ENDGAME_H
+#define TEAM03_ENDGAME_H
+/**
+ * An empty square in the endgame solver's list of empties.
+ */
+typedef struct team03_empty {
+    struct team03_empty *prev, *next;
+    int8_t square; // bit index
+    uint8_t quadrant; // the square's quadrant, as a bit of the parity mask
+} team03_empty_t;
+
+/**
+ * State for one exact endgame solve: the empty squares, best ones first,
+ * as a linked list that moves are unlinked from and relinked into.
+ */
+typedef struct team03_endgame {
+    team03_empty_t head; // sentinel; the list runs from `head.next`
+    team03_empty_t squares[64];
+    long long nodes;
+} team03_endgame_t;
+#endif // TEAM03_ENDGAME_H
+
+#ifndef TEAM03_ORDERSTATS_H
+#define TEAM03_ORDERSTATS_H
+/**
+ * How often beta cutoffs came from a node's first move, i.e. how good
+ * the move ordering is. Kept per thread.
+ */
+typedef struct team03_orderStats {
+    long long cutoffs; // beta cutoffs at interior nodes
+    long long firstCutoffs; // ...of which the first move searched caused
+} team03_orderStats_t;
+#endif // TEAM03_ORDERSTATS_H
+
+#ifndef TEAM03_PATTERNS_H
+#define TEAM03_PATTERNS_H
+// Evaluation layout: the weights are split into this many phases, by disc
+// count; there are 34 pattern instances, whose tables (one set per phase)
+// sit end to end, padded for the 4-byte gathers
+#define TEAM03_EVAL_PHASES 4
+#define TEAM03_PATTERNS 34
+#define TEAM03_PATTERN_TABLE_SIZE 147582 // sum of 3^size over the types
+#define TEAM03_PATTERN_TABLE_STRIDE 147584
+
+/**
+ * The base-3 code of every evaluation pattern instance for a board, and
+ * the discs they were computed for (so a child's codes can be updated
+ * from them). Each code is kept as the instance's index into its phase's
+ * tables (its type's offset plus the code), ready for the lookup.
+ */
+typedef struct team03_patterns {
+    uint64_t on, color;
+    uint32_t indices[TEAM03_PATTERNS];
+} team03_patterns_t;
+#endif // TEAM03_PATTERNS_H
+
+#ifndef TEAM03_STATS_H
+#define TEAM03_STATS_H
+/**
+ * Search counters. Kept per thread (padded to a cache line, and the
+ * array aligned to one, since every node bumps them); the cutoff counts
+ * are only filled in when the counters are summed, from
+ * `team03_orderStats_t`.
+ */
+typedef struct team03_nodeStats {
+    long long nodes; // nodes visited, endgame solver nodes included
+    long long leaves; // static evaluations at the search horizon
+    long long ttProbes, ttHits;
+    long long cutoffs, firstCutoffs;
+    long long pad[2];
+} team03_nodeStats_t;
+
+/**
+ * One iteration of a move's search: a depth of iterative deepening, or
+ * an endgame solve.
+ */
+typedef struct team03_iterStats {
+    const char *search; // "midgame", "wld" or "exact"
+    int depth; // layers searched, or empties solved
+    int complete; // 0 if it ran out of time
+    long long nodes, leaves, ms;
+} team03_iterStats_t;
+
+/**
+ * Statistics for one move's search.
+ */
+typedef struct team03_moveStats {
+    int turn, color;
+    pos_t move;
+    int depth; // deepest completed iteration
+    long long ms;
+    team03_nodeStats_t totals;
+    int numIters;
+    team03_iterStats_t iters[32]; // ID depths, plus the endgame solves
+} team03_moveStats_t;
+#endif // TEAM03_STATS_H
+
+#ifndef TEAM03_SPLIT_H
+#define TEAM03_SPLIT_H
+/**
+ * A YBWC split point: a node whose eldest child has been searched and
+ * whose remaining moves are shared between threads. Lives on its owner's
+ * stack until every thread working on it has signed off.
+ */
+typedef struct team03_split {
+    struct team03_split *parent; // the split point the owner was working under
+    team03_lock_t lock; // guards everything below
+    board_t state;
+    int color, layer;
+    int endgame; // the moves are solved exactly; `layer` is the empties
+    int alpha, beta, best;
+    pos_t bestPos;
+    solvePair_t *moves;
+    int num, next; // # of moves; index of the next move to hand out
+    volatile int workers; // # of thieves (not the owner) working on it
+    volatile int abort; // set on a cutoff; everything below unwinds
+    int cutoff, incomplete;
+} team03_split_t;
+
+/**
+ * A thread's deque of open split points, oldest first. The owner pushes
+ * and pops at the end; thieves join split points from the front.
+ */
+typedef struct team03_deque {
+    team03_lock_t lock;
+    team03_split_t *items[64];
+    int size;
+} team03_deque_t;
+#endif // TEAM03_SPLIT_H
+
+#ifndef TEAM03_HELPER_H
+#define TEAM03_HELPER_H
+/**
+ * A Lazy SMP helper thread and the root position it searches.
+ */
+typedef struct team03_helper {
+#ifdef TEAM03_IS_POSIX
+    pthread_t thread;
+#endif
+    int id, running;
+    int endgame; // solve the position instead of searching it
+    board_t state;
+    int color, num;
+    solvePair_t moveList[64];
+} team03_helper_t;
+#endif // TEAM03_HELPER_H
+
+
+/*
+ **********************
+ * Shared state       *
+ **********************
+ */
+
+// Parallel search backends, for `team03_parallel`
+#define TEAM03_PARALLEL_LAZY 0
+#define TEAM03_PARALLEL_YBWC 1
+
+// The parallel search backend in use
+extern int team03_parallel;
+
+// The calling thread's index into the per-thread tables (0 for the main
+// thread); set by each search thread when it starts
+extern TEAM03_TLS int team03_threadId;
+
+// Evaluation weights (pattern tables, mobility, parity and stability)
+// by phase, and the phase for each disc count; filled in by
+// `team03_init`
+extern int16_t team03_evalTable[TEAM03_EVAL_PHASES][TEAM03_PATTERN_TABLE_STRIDE];
+extern int team03_mobilityWeights[TEAM03_EVAL_PHASES];
+extern int team03_parityWeights[TEAM03_EVAL_PHASES];
+extern int team03_stabilityWeights[TEAM03_EVAL_PHASES];
+extern int team03_evalPhase[65];
+
+
+/*
+ **********************
+ * Game interface     *
+ **********************
+ */
+
+/**
+ * Performs a move for our team. Defers to `getMove`.
+ *
+ * @param board the (slow/default) board state, which we'll load to our board type
+ * @param mine which piece color we're playing
+ * @param secondsleft how much time we have left for the game
+ *
+ * @return the position we place a piece at.
+ */
+position *team03Move(const enum piece board[][SIZE], enum piece mine, int secondsleft);
+
+/**
+ * Performs a move for our team.
+ *
+ * @param board the current board state
+ * @param color the color we're playing (0/1 for black/white)
+ * @param time the time (in seconds) our team has left on the game timer
+ *
+ * @return the position we placed a piece at
+ */
+pos_t team03_getMove(board_t state, int color, int time);
+
+/**
+ * Builds all of the lookup tables used by the bot. Safe to call more
+ * than once; only the first call does any work.
+ */
+void team03_init(void);
+
+/**
+ * Compares two strings, ignoring ASCII case (for environment settings).
+ *
+ * @param a the first string
+ * @param b the second string
+ *
+ * @return whether the strings are equal up to case
+ */
+int team03_equalsIgnoreCase(const char *a, const char *b);
+
+
+/*
+ **********************
+ * Heuristics         *
+ **********************
+ */
+
+/**
+ * Allocates time for this turn, returning a bound for the max
+ * amount of time to spend on the current move (in ms).
+ *
+ * @param state the current board state
+ * @param color our piece color
+ * @param time how many seconds we have left
+ *
+ * @return the max time for this turn, in ms
+ */
+long long team03_allocateTime(board_t state, int color, int timeLeft);
+
+/**
+ * Computes a relative score for how many of the pieces on th
+ * board we currently own. Not weighted very highly.
+ *
+ * @param state the board state
+ * @param color the color to count pieces for
+ *
+ * @return the fraction of pieces we own on the board
+ */
+float team03_computeParity(board_t state, int color);
+
+/**
+ * Computes the given color's mobility for the current board state,
+ * counting the number of valid moves that color can take.
+ *
+ * @param state the current board state
+ * @param color the color to consider moves for
+ *
+ * @return the number of valid moves that the color can take
+ */
+int team03_computeMobility(board_t state, int color);
+
+/**
+ * Scalar mobility kernel; counts the bits in the legal move mask.
+ *
+ * @param state the current board state
+ * @param color the color to consider moves for
+ *
+ * @return the number of valid moves that the color can take
+ */
+int team03_computeMobilityScalar(board_t state, int color);
+
+/**
+ * Computes the given color's mobility advantage: its number of valid
+ * moves less its opponent's.
+ *
+ * @param state the current board state
+ * @param color the color to consider moves for
+ *
+ * @return the difference in the number of valid moves
+ */
+int team03_computeMobilityDiff(board_t state, int color);
+
+/**
+ * Scalar mobility advantage kernel; one mobility count per side.
+ *
+ * @param state the current board state
+ * @param color the color to consider moves for
+ *
+ * @return the difference in the number of valid moves
+ */
+int team03_computeMobilityDiffScalar(board_t state, int color);
+
+/**
+ * Finds a lower bound on the given color's stable discs: ones that can
+ * never be flipped again. A disc is stable if, along each of the four
+ * lines through it, the line is full or one of its two neighbours is off
+ * the board or a stable disc of the same color. Starting from none, the
+ * rule is applied until nothing changes (corners go first, since they
+ * have no neighbours on any line).
+ *
+ * @param state the board state
+ * @param color the color to find stable discs for
+ *
+ * @return a mask of the color's stable discs
+ */
+uint64_t team03_getStable(board_t state, int color);
+
+/**
+ * Counts a color's stable discs minus its opponent's, for the static
+ * evaluation. There are hardly ever any before a corner is taken, so the
+ * search for them is skipped until then.
+ *
+ * @param state the board state
+ * @param color the color to count for
+ *
+ * @return the difference in stable discs (a lower bound for each side)
+ */
+int team03_getStableDiff(board_t state, int color);
+
+/**
+ * Gathers the squares of every pattern instance from a bitboard, as a
+ * binary number per instance with digit k of the pattern in bit k. The
+ * instances are read off the board's symmetric images, so each type's
+ * instances line up square for square.
+ *
+ * @param x the bitboard (one color's discs)
+ * @param out the gathered bits, per instance
+ */
+void team03_gatherPatterns(uint64_t x, uint16_t *out);
+
+/**
+ * Computes the pattern codes of a board from scratch.
+ *
+ * @param out the codes to fill in (as table indices)
+ * @param state the board state
+ */
+void team03_computePatterns(team03_patterns_t *out, board_t state);
+
+/**
+ * Updates pattern codes to a board with the same discs and more, like a
+ * child of the board they're for: only the digits of the squares that
+ * were filled or flipped change. Otherwise (or with no codes to start
+ * from) they're computed from scratch.
+ *
+ * @param out the codes to fill in
+ * @param from the codes to start from, or NULL
+ * @param state the board state to update them to
+ */
+void team03_updatePatterns(team03_patterns_t *out, const team03_patterns_t *from, board_t state);
+
+/**
+ * Evaluates the board with the pattern tables for the given phase. Uses
+ * the current node's codes if they're for this board, and computes them
+ * otherwise.
+ *
+ * @param state the board state
+ * @param phase the board's phase (from its disc count)
+ *
+ * @return the score from black's point of view
+ */
+int team03_evaluatePatterns(board_t state, int phase);
+
+/**
+ * Scalar pattern sum kernel: one load per instance, into two running
+ * sums so the loads don't wait on each other's adds.
+ *
+ * @param table the phase's pattern tables
+ * @param indices each instance's index into the tables
+ *
+ * @return the sum of the instances' weights
+ */
+int team03_sumPatternsScalar(const int16_t *table, const uint32_t *indices);
+
+#ifdef TEAM03_IS_X86
+/**
+ * AVX2 pattern sum kernel: gathers 8 instances' weights at a time, as
+ * 32-bit loads at the weights' addresses (hence the tables' padding);
+ * a multiply-add by (1, 0) keeps each load's low half, sign-extended.
+ *
+ * @param table the phase's pattern tables
+ * @param indices each instance's index into the tables
+ *
+ * @return the sum of the instances' weights
+ */
+TEAM03_TARGET("avx2")
+int team03_sumPatternsAVX2(const int16_t *table, const uint32_t *indices);
+#endif // TEAM03_IS_X86
+
+/**
+ * Builds the pattern tables: each instance's squares and table offset,
+ * each square's instances, the base-3 conversions and phases, and the
+ * default weights (see `team03_defaultWeight`).
+ */
+void team03_initPatterns(void);
+
+/**
+ * Scores a pattern configuration by hand, for want of trained weights:
+ * square values and a disc count term shared out over the instances
+ * covering each square, plus, for edges, the X and C squares next to an
+ * empty corner and discs anchored to an occupied one.
+ *
+ * @param pattern the pattern instance whose squares to use
+ * @param phase the game phase
+ * @param code the base-3 code of the configuration
+ * @param coverage the number of instances covering each square
+ *
+ * @return the weight, from black's point of view
+ */
+int team03_defaultWeight(int pattern, int phase, int code, const int *coverage);
+
+/**
+ * Reads or writes one little-endian int32 of a weights file.
+ *
+ * @param file the weights file
+ * @param value the value to write, or where to read it to
+ * @param write 1 to write, 0 to read
+ *
+ * @return 1 on success, 0 on failure
+ */
+int team03_weightsInt(FILE *file, int *value, int write);
+
+/**
+ * Clamps a pattern weight to what the tables can hold.
+ *
+ * @param weight the weight
+ *
+ * @return the weight, clamped to +/- 32767
+ */
+int16_t team03_clampWeight(int weight);
+
+/**
+ * Loads evaluation weights (pattern tables, mobility, parity and
+ * stability) from a file written by `team03_saveWeights`. The current
+ * weights are kept unless the whole file is read and matches our layout;
+ * pattern weights are clamped to fit the tables. Version 1 files, from
+ * before the stability weights, keep the current ones.
+ *
+ * @param path the weights file
+ *
+ * @return 1 if the weights were loaded, 0 otherwise
+ */
+int team03_loadWeights(const char *path);
+
+/**
+ * Writes the current evaluation weights to a file, for
+ * `team03_loadWeights`.
+ *
+ * @param path the weights file
+ *
+ * @return 1 on success, 0 on failure
+ */
+int team03_saveWeights(const char *path);
+
+/**
+ * Statically evaluate the current board position for a given color.
+ * Only accounts for the current level, disregarding future moves.
+ *
+ * @param state the current board state
+ * @param color the color to evaluate for
+ *
+ * @return a relative score for the current board state
+ */
+int team03_evaluateStatic(board_t state, int color);
+
+
+/*
+ **********************
+ * The actual bot lol *
+ **********************
+ */
+
+/**
+ * Iteratively deepens the search tree, evaluating at higher and
+ * higher depths until we've used as much time as we want.
+ * <br/><br/>
+ * If we have more than one thread, the helpers run the same search
+ * (Lazy SMP) and share what they find through the transposition table;
+ * only this thread's result is used.
+ *
+ * @param state the current board state
+ * @param color our color
+ *
+ * @return the best move we find before we use the allotted time
+ */
+pos_t team03_iterate(board_t state, int color);
+
+/**
+ * Searches the root to the given depth with an aspiration window around
+ * the given score. On a fail low or high, the failing side of the window
+ * is widened by doubling its margin, until the score lands inside it or
+ * the window is full.
+ * <br/><br/>
+ * If a fail-high move is found, it's already better than anything from
+ * the last depth, so `retPos` is updated with it straight away in case
+ * the re-search runs out of time.
+ *
+ * @param state the current board state
+ * @param color our color
+ * @param moveList the root moves, best first
+ * @param num the number of root moves
+ * @param layers the depth to search to
+ * @param center the expected score (from an earlier depth)
+ * @param retPos the best move so far; updated on fail highs
+ *
+ * @return the best move at this depth, or (-2, -2) if we ran out of time
+ */
+pos_t team03_aspirate(board_t state, int color, solvePair_t *moveList, int num, int layers,
+                      int center, pos_t *retPos);
+
+/**
+ * Searches every root move to the given depth, updating each move's score
+ * with the result and re-sorting the move list on the updated scores.
+ *
+ * @param state the current board state
+ * @param color our color
+ * @param moveList the root moves, best first
+ * @param num the number of root moves
+ * @param layers the depth to search to
+ * @param alpha the root's alpha
+ * @param beta the root's beta
+ *
+ * @return the best move at this depth, or (-2, -2) if we ran out of time
+ */
+pos_t team03_searchRoot(board_t state, int color, solvePair_t *moveList, int num, int layers,
+                        int alpha, int beta);
+
+/**
+ * Finds the best move by searching up to the given depth. If we
+ * use all of the allotted time (> team03_maxTime ms), returns a
+ * pair with position (-2, -2).
+ * <br/><br/>
+ * The node's pattern codes live in this frame, updated from the
+ * parent's, for the static evaluation at the leaves.
+ *
+ * @param state the current board state
+ * @param color the current color being considered
+ * @param layer the number of layers to search through
+ * @param alpha the alpha
+ * @param beta the beta
+ *
+ * @return the best move
+ */
+solvePair_t team03_solveBoard(board_t state, int color, int layer, int alpha, int beta);
+/**
+ * Searches a node for `team03_solveBoard`, once its pattern codes are
+ * set up.
+ *
+ * @param state the current board state
+ * @param color the current color being considered
+ * @param layer the number of layers to search through
+ * @param alpha the alpha
+ * @param beta the beta
+ *
+ * @return the best move, or position (-2, -2) if we ran out of time
+ */
+solvePair_t team03_solveNode(board_t state, int color, int layer, int alpha, int beta);
+
+/**
+ * Searches a child node from the parent's point of view, i.e. the
+ * returned pair is the child's (opponent's) result for the window
+ * (-beta, -alpha). With PVS on, every child but the first is searched
+ * with a null window around alpha first, and only re-searched with the
+ * full window if it beats alpha.
+ *
+ * @param child the child board state
+ * @param color the color to move in the child
+ * @param layer the number of layers to search through
+ * @param alpha the parent's alpha
+ * @param beta the parent's beta
+ * @param first whether this is the parent's first (presumed best) move
+ *
+ * @return the child's result, as from `team03_solveBoard`
+ */
+solvePair_t team03_searchChild(board_t child, int color, int layer, int alpha, int beta, int first);
+
+/**
+ * Statically evaluates all of color's moves for the current board
+ * state, outputting a list pairing move positions with the static
+ * scores of the resulting positions in descending order of value.
+ * <br/><br/>
+ * If evaluate is 0, instead just gets the moves that are valid.
+ *
+ * @param state the current board state
+ * @param color the color to check moves for
+ * @param arr a pointer to an array solvePair_t[64]
+ * @param evaluate whether to evaluate and sort the move list before returning
+ * 
+ * @return the result array size
+ */
+int team03_getMoves(board_t state, int color, solvePair_t *arr, int evaluate);
+
+/**
+ * Ranks all of color's moves by a shallow full-window search of each
+ * resulting position, outputting them in descending order of score.
+ *
+ * @param state the current board state
+ * @param color the color to check moves for
+ * @param arr a pointer to an array solvePair_t[64]
+ * @param layers the depth to search each move to (counting the move)
+ *
+ * @return the result array size, or -1 if we ran out of time
+ */
+int team03_rankMoves(board_t state, int color, solvePair_t *arr, int layers);
+
+
+/*
+ **********************
+ * Move ordering      *
+ **********************
+ */
+
+/**
+ * Sets up a move picker for an interior node.
+ *
+ * @param picker the picker to set up
+ * @param state the node's board state
+ * @param color the color to move
+ * @param moves the node's legal moves
+ * @param ttMove the bit index of the table's best move, or -1 if none
+ */
+void team03_initPicker(team03_picker_t *picker, board_t state, int color, uint64_t moves, int ttMove);
+
+/**
+ * Sets up a move picker that hands out an already ranked move list in
+ * order, skipping the stages.
+ *
+ * @param picker the picker to set up
+ * @param list the ranked moves; must outlive the picker
+ * @param num the number of moves
+ */
+void team03_initPickerList(team03_picker_t *picker, const solvePair_t *list, int num);
+
+/**
+ * Picks the next move to search: the transposition table's move, then
+ * corners, then this ply's killer moves, then the rest one at a time by
+ * their history and square scores. List pickers just go down the list.
+ *
+ * @param picker the node's move picker
+ *
+ * @return the move's bit index, or -1 if there are no moves left
+ */
+int team03_nextMove(team03_picker_t *picker);
+
+/**
+ * Records a beta cutoff: the move becomes this ply's first killer and
+ * its history score goes up by the square of the remaining depth.
+ *
+ * @param state the node's board state
+ * @param color the color to move
+ * @param layer the node's remaining depth
+ * @param move the move that caused the cutoff
+ * @param tried how many moves were searched before it
+ */
+void team03_recordCutoff(board_t state, int color, int layer, pos_t move, int tried);
+
+/**
+ * Halves every thread's history scores, so the ordering adapts as the
+ * game goes on. Called once per move.
+ */
+void team03_ageHistory(void);
+
+/**
+ * Computes the share of beta cutoffs caused by the first move searched,
+ * over every thread and the whole game so far.
+ *
+ * @return the first-move cutoff rate in [0, 1], or 0 if there were none
+ */
+double team03_firstCutoffRate(void);
+
+
+/*
+ **********************
+ * Endgame solver     *
+ **********************
+ */
+
+/**
+ * Picks a move for a position near the end of the game. Iterative
+ * deepening (with the helpers) orders the moves and gives a fallback,
+ * then every thread works on proving the outcome and, if there are few
+ * enough empties, finding the exact score. The best move from the last
+ * search or solve to finish is played.
+ *
+ * @param state the current board state
+ * @param color our color
+ * @param moveList the root moves
+ * @param num the number of root moves
+ *
+ * @return the position we place a piece at
+ */
+pos_t team03_iterateEndgame(board_t state, int color, solvePair_t *moveList, int num);
+
+/**
+ * Solves the root of an endgame exactly, searching the moves in the
+ * order given and updating their scores (exact only within the window).
+ * Under YBWC, the moves after the first are shared between threads.
+ *
+ * @param state the current board state
+ * @param color the color to move
+ * @param moveList the root moves; re-sorted on the updated scores
+ * @param num the number of root moves
+ * @param alpha the root's alpha, in discs
+ * @param beta the root's beta, in discs
+ *
+ * @return the best move and its final disc differential, or position
+ * (-2, -2) if we ran out of time
+ */
+solvePair_t team03_solveEndgameRoot(board_t state, int color, solvePair_t *moveList, int num,
+                                    int alpha, int beta);
+
+/**
+ * Builds the endgame solver's list of empties (best squares first) and
+ * the parity mask for a position.
+ *
+ * @param eg the solver state to fill in
+ * @param state the board state
+ *
+ * @return the parity mask: bit q is set if quadrant q has an odd number
+ * of empties
+ */
+int team03_initEmpties(team03_endgame_t *eg, board_t state);
+
+/**
+ * Solves a position exactly with alpha-beta, returning the final disc
+ * differential (fail-soft). With many empties, moves are tried fastest
+ * first, i.e. by the opponent's mobility after them; near the end they're
+ * just taken from the empties list, odd quadrants first. No static
+ * evaluation is involved. Under YBWC, nodes with TEAM03_YBWC_MIN_EMPTIES
+ * or more empties are split once their eldest child is solved.
+ *
+ * @param eg the solver state; its list must match the board
+ * @param state the board state
+ * @param color the color to move
+ * @param alpha the alpha, in discs
+ * @param beta the beta, in discs
+ * @param empties the number of empty squares
+ * @param parity the parity mask (see `team03_initEmpties`)
+ * @param passed whether the last move was a pass
+ *
+ * @return the best move and its score, or position (-2, -2) if we ran
+ * out of time
+ */
+solvePair_t team03_solveEndgame(team03_endgame_t *eg, board_t state, int color, int alpha, int beta,
+                                int empties, int parity, int passed);
+
+/**
+ * Solves a position with one empty square left. No child board is built;
+ * the score follows from the number of discs the last move flips.
+ *
+ * @param state the board state
+ * @param color the color to move
+ * @param sq the bit index of the empty square
+ *
+ * @return the final disc differential
+ */
+int team03_solveLast1(board_t state, int color, int8_t sq);
+
+/**
+ * Solves a position with two empty squares left.
+ *
+ * @param state the board state
+ * @param color the color to move
+ * @param alpha the alpha, in discs
+ * @param beta the beta, in discs
+ * @param sqs the bit indices of the empty squares
+ * @param passed whether the last move was a pass
+ *
+ * @return the final disc differential (fail-soft)
+ */
+int team03_solveLast2(board_t state, int color, int alpha, int beta, const int8_t *sqs, int passed);
+
+/**
+ * Solves a position with three empty squares left.
+ *
+ * @param state the board state
+ * @param color the color to move
+ * @param alpha the alpha, in discs
+ * @param beta the beta, in discs
+ * @param sqs the bit indices of the empty squares, best first
+ * @param passed whether the last move was a pass
+ *
+ * @return the final disc differential (fail-soft)
+ */
+int team03_solveLast3(board_t state, int color, int alpha, int beta, const int8_t *sqs, int passed);
+
+/**
+ * Solves a position with four empty squares left.
+ *
+ * @param state the board state
+ * @param color the color to move
+ * @param alpha the alpha, in discs
+ * @param beta the beta, in discs
+ * @param sqs the bit indices of the empty squares, best first
+ * @param passed whether the last move was a pass
+ *
+ * @return the final disc differential (fail-soft)
+ */
+int team03_solveLast4(board_t state, int color, int alpha, int beta, const int8_t *sqs, int passed);
+
+/**
+ * Plays a move whose flips are already known. Only keeps the hash up to
+ * date if asked to, since the solver's small subtrees don't need it.
+ *
+ * @param state the board state
+ * @param ind the bit index of the move
+ * @param flips the pieces it flips
+ * @param color the color moving
+ * @param hashed whether to update the hash
+ *
+ * @return the new board state
+ */
+board_t team03_playFlips(board_t state, int8_t ind, uint64_t flips, int color, int hashed);
+
+/**
+ * Computes the final disc differential of a finished game.
+ *
+ * @param state the board state
+ * @param color the color to score for
+ *
+ * @return color's discs minus the opponent's
+ */
+int team03_finalScore(board_t state, int color);
+
+
+/*
+ **********************
+ * Pondering          *
+ **********************
+ */
+
+/**
+ * Starts pondering on the position after our move: a background thread
+ * searches every reply (or, if the opponent has to pass, our next move)
+ * with no time limit until `team03_stopPonder` is called. Near the end
+ * it runs the endgame solves instead, so their table entries are there.
+ * The table is aged here rather than in `team03_getMove`, so the entries
+ * are the same age as the next move's own.
+ *
+ * @param state the board state after our move
+ * @param color the color to move (the opponent)
+ */
+void team03_startPonder(board_t state, int color);
+
+/**
+ * Stops the pondering thread, if it's running, and waits for it to
+ * unwind.
+ */
+void team03_stopPonder(void);
+
+/**
+ * Entry point for the pondering thread: iterative deepening over the
+ * pondered position's moves, or the endgame solves if it's close enough
+ * to the end, until it's stopped. Results only land in the transposition
+ * table.
+ *
+ * @param arg the ponder thread's `team03_helper_t`
+ *
+ * @return NULL
+ */
+void *team03_ponderMain(void *arg);
+
+
+/*
+ **********************
+ * Search timer       *
+ **********************
+ */
+
+/**
+ * Arms the deadline for a search, `team03_maxTime` ms after
+ * `team03_startTime` but on the monotonic clock, and clears the stop
+ * flag. On POSIX a timer thread raises the flag when the deadline passes;
+ * otherwise (or if the thread can't be created) the searches notice by
+ * checking the clock now and then, in `team03_timeUp`.
+ */
+void team03_startTimer(void);
+
+/**
+ * Stops the timer thread, if it's running, and waits for it to exit.
+ */
+void team03_stopTimer(void);
+
+/**
+ * Lowers the stop flag again after the helpers were stopped mid-move,
+ * unless the deadline has passed. The deadline is checked after the flag
+ * is lowered, so a timer firing in between can't be lost.
+ *
+ * @return 1 if there's still time to search; otherwise 0
+ */
+int team03_resumeTimer(void);
+
+/**
+ * Entry point for the timer thread: sleeps in short slices until the
+ * deadline passes or the timer is stopped, then raises `team03_stop`.
+ *
+ * @param arg unused
+ *
+ * @return NULL
+ */
+void *team03_timerMain(void *arg);
+
+/**
+ * Checks whether the search should unwind. Usually just a load of the
+ * stop flag; every `TEAM03_POLL_NODES` calls per thread it also checks
+ * the deadline itself, raising the flag if it's passed.
+ *
+ * @return 1 if the search should stop, 0 otherwise
+ */
+int team03_timeUp(void);
+
+
+/*
+ **********************
+ * Search statistics  *
+ **********************
+ */
+
+/**
+ * Sums the search counters over every thread.
+ *
+ * @return the summed counters
+ */
+team03_nodeStats_t team03_sumNodeStats(void);
+
+/**
+ * Starts collecting statistics for a move's search.
+ *
+ * @param state the board state being searched
+ * @param color our color
+ */
+void team03_startStats(board_t state, int color);
+
+/**
+ * Records an iteration of the current move's search: the nodes searched
+ * and the time taken since the last one.
+ *
+ * @param search the kind of search ("midgame", "wld" or "exact")
+ * @param depth the layers searched, or empties solved
+ * @param complete whether it finished in time
+ */
+void team03_recordIteration(const char *search, int depth, int complete);
+
+/**
+ * Finishes the current move's statistics and, if there's a stats file,
+ * writes them out.
+ *
+ * @param move the move we chose
+ */
+void team03_finishStats(pos_t move);
+
+/**
+ * Writes a move's statistics as a single JSON line.
+ *
+ * @param out the file to write to
+ * @param stats the statistics
+ */
+void team03_writeStats(FILE *out, const team03_moveStats_t *stats);
+
+
+/*
+ **********************
+ * Lazy SMP           *
+ **********************
+ */
+
+/**
+ * Starts the helper threads on a search of the given root position. Each
+ * helper gets its own copy of the move list, rotated by its id so the
+ * helpers don't all walk the tree in the same order, and starts at a
+ * staggered depth (or, in the endgame, runs the same solves as us). YBWC
+ * helpers ignore the position and steal work from our split points.
+ *
+ * @param state the root board state
+ * @param color the color to move
+ * @param moveList the root moves, best first
+ * @param num the number of root moves
+ * @param endgame 1 to solve the position instead of searching it
+ */
+void team03_startHelpers(board_t state, int color, const solvePair_t *moveList, int num, int endgame);
 
-#ifndef POS_H
-#define POS_H
 /**
- * Lightweight position struct.
- * y=row, x=col
+ * Signals the helper threads to stop and waits for them to exit.
  */
-typedef struct pos {
-    int8_t y, x; // signed to avoid underflow issues in move loops
-} pos_t;
-#endif // POS_H
+void team03_stopHelpers(void);
 
-#ifndef SOLVEPAIR_H
-#define SOLVEPAIR_H
 /**
- * A solve result to return from move evaluation functions.
+ * Entry point for a helper thread. Runs iterative deepening on the
+ * helper's root position until the main thread stops it or time runs
+ * out; odd helpers start one layer deeper, so at any time the threads
+ * are spread over two depths. Results only land in the transposition
+ * table. Under YBWC, helpers only steal work from split points instead,
+ * in the endgame solver as well as in the search.
+ *
+ * @param arg the helper's `team03_helper_t`
+ *
+ * @return NULL
  */
-typedef struct solvePair {
-    pos_t pos;
-    int score;
-} solvePair_t;
-#endif // SOLVEPAIR_H
+void *team03_helperMain(void *arg);
+
+/**
+ * Solves a helper's root position: proves the outcome, then finds the
+ * exact score if there are few enough empties. Results only land in the
+ * transposition table.
+ *
+ * @param helper the helper (or ponder thread)
+ */
+void team03_solveHelper(team03_helper_t *helper);
 
 
 /*
  **********************
- * Game interface     *
+ * YBWC               *
  **********************
  */
 
 /**
- * Performs a move for our team. Defers to `getMove`.
+ * Checks whether a node at the given depth should be split between
+ * threads under the YBWC backend.
  *
- * @param board the (slow/default) board state, which we'll load to our board type
- * @param mine which piece color we're playing
- * @param secondsleft how much time we have left for the game
+ * @param layer the node's remaining depth
  *
- * @return the position we place a piece at.
+ * @return 1 if the node's younger brothers should be shared; otherwise 0
  */
-position *team03Move(const enum piece board[][SIZE], enum piece mine, int secondsleft);
+int team03_canSplit(int layer);
 
 /**
- * Performs a move for our team.
+ * Checks whether an endgame solver node with the given number of empties
+ * should be split between threads under the YBWC backend.
  *
- * @param board the current board state
- * @param color the color we're playing (0/1 for black/white)
- * @param time the time (in seconds) our team has left on the game timer
+ * @param empties the node's number of empty squares
  *
- * @return the position we placed a piece at
+ * @return 1 if the node's younger brothers should be shared; otherwise 0
  */
-pos_t team03_getMove(board_t state, int color, int time);
+int team03_canSplitEndgame(int empties);
 
+/**
+ * Searches the remaining moves of a node in parallel. The node becomes a
+ * split point on this thread's deque; idle threads steal moves from it
+ * while this thread works through them too. A beta cutoff aborts every
+ * move still being searched below the split point. Each move's score is
+ * written back to `pairs` (a bound, outside the window it was given).
+ *
+ * @param state the node's board state
+ * @param color the color to move
+ * @param layer the node's remaining depth, or its empties in the endgame
+ * @param alpha the node's alpha; updated with the result
+ * @param beta the node's beta
+ * @param best the node's best score so far; updated with the result
+ * @param bestPos the node's best move so far; updated with the result
+ * @param pairs the node's moves; the first has already been searched
+ * @param num the number of moves
+ * @param endgame 1 if the moves are to be solved exactly (scores in discs)
+ *
+ * @return 0 if all moves were searched, 1 on a beta cutoff, or -1 if we
+ * ran out of time or a split point above us was aborted
+ */
+int team03_split(board_t state, int color, int layer, int *alpha, int beta,
+                 int *best, pos_t *bestPos, solvePair_t *pairs, int num, int endgame);
 
-/*
- **********************
- * Heuristics         *
- **********************
+/**
+ * Claims and searches moves from a split point until there are none
+ * left or it's aborted.
+ *
+ * @param sp the split point
  */
+void team03_splitWork(team03_split_t *sp);
 
 /**
- * Allocates time for this turn, returning a bound for the max
- * amount of time to spend on the current move (in ms).
+ * Solves a move handed out from an endgame split point, with solver
+ * state of its own: a null window first, as a younger brother, then the
+ * full window if the score lands inside it.
  *
- * @param state the current board state
- * @param color our piece color
- * @param time how many seconds we have left
+ * @param child the board after the move
+ * @param color the color to move in the child
+ * @param empties the child's number of empty squares
+ * @param alpha the split point's alpha
+ * @param beta the split point's beta
  *
- * @return the max time for this turn, in ms
+ * @return the child's result, as from `team03_solveEndgame`
  */
-long long team03_allocateTime(board_t state, int color, int timeLeft);
+solvePair_t team03_solveSplitChild(board_t child, int color, int empties, int alpha, int beta);
 
 /**
- * Computes a relative score for how many of the pieces on th
- * board we currently own. Not weighted very highly.
+ * Tries to steal work: scans the other threads' deques, oldest (largest)
+ * split points first, and joins the first one with moves left.
  *
- * @param state the board state
- * @param color the color to count pieces for
+ * @param ancestor if not NULL, only split points below this one qualify
+ * (used by a split point's owner while it waits for thieves)
  *
- * @return the fraction of pieces we own on the board
+ * @return 1 if we found and did some work; otherwise 0
  */
-float team03_computeParity(board_t state, int color);
+int team03_steal(team03_split_t *ancestor);
 
 /**
- * Computes the given color's mobility for the current board state,
- * counting the number of valid moves that color can take.
+ * Checks whether a split point or any split point above it was aborted.
  *
- * @param state the current board state
- * @param color the color to consider moves for
+ * @param sp the innermost split point, or NULL
  *
- * @return the number of valid moves that the color can take
+ * @return 1 if the search below `sp` should unwind; otherwise 0
  */
-int team03_computeMobility(board_t state, int color);
+int team03_splitAborted(team03_split_t *sp);
 
 /**
- * Statically evaluate the current board position for a given color.
- * Only accounts for the current level, disregarding future moves.
+ * Checks whether a split point lies below another one.
  *
- * @param state the current board state
- * @param color the color to evaluate for
+ * @param sp the split point to check
+ * @param ancestor the possible ancestor
  *
- * @return a relative score for the current board state
+ * @return 1 if `ancestor` is on `sp`'s parent chain; otherwise 0
  */
-int team03_evaluateStatic(board_t state, int color);
+int team03_splitDescends(team03_split_t *sp, team03_split_t *ancestor);
+
+/**
+ * Gives up the rest of this thread's time slice while it waits for work.
+ */
+void team03_yield(void);
+
+/**
+ * Prints how much faster the current parallel backend searches the given
+ * position to a fixed depth with 1, 2, 4, 8 and 16 threads than with one.
+ * Positions with TEAM03_ENDGAME_EMPTIES or fewer empties are solved
+ * exactly instead, with the helpers doing what they do in a game. The
+ * transposition table is cleared before each run, and the scores are
+ * printed so differences in the result can be spotted, along with the
+ * share of cutoffs caused by the first move searched.
+ *
+ * @param state the position to search
+ * @param color the color to move
+ * @param layers the depth to search to (with iterative deepening); not
+ * used for endgame positions
+ * @param out the stream to print the report to
+ */
+void team03_reportSpeedup(board_t state, int color, int layers, FILE *out);
 
 
 /*
  **********************
- * The actual bot lol *
+ * Transposition table*
  **********************
  */
 
 /**
- * Iteratively deepens the search tree, evaluating at higher and
- * higher depths until we've used as much time as we want.
+ * (Re)allocates the transposition table with the given size, rounded
+ * down to a power-of-two number of buckets, and clears it. Sizes are
+ * clamped to TEAM03_HASH_MAX_MB; if the allocation fails, the size is
+ * halved until it succeeds, and the process exits (status 1) if not even
+ * a single bucket can be allocated.
  *
- * @param state the current board state
- * @param color our color
+ * @param megabytes the table size in MB
+ */
+void team03_ttResize(size_t megabytes);
+
+/**
+ * Clears every entry in the transposition table.
+ */
+void team03_ttClear(void);
+
+/**
+ * Starts a new search (move) by aging the table, so entries from earlier
+ * moves are replaced first but can still be hit.
+ */
+void team03_ttNewSearch(void);
+
+/**
+ * Looks up the given key in the transposition table.
  *
- * @return the best move we find before we use the allotted time
+ * @param key the position key (see `team03_hashKey`)
+ * @param out where to unpack the entry, if found
+ *
+ * @return 1 if the key was found; otherwise 0
  */
-pos_t team03_iterate(board_t state, int color);
+int team03_ttProbe(uint64_t key, team03_ttData_t *out);
 
 /**
- * Finds the best move by searching up to the given depth. If we
- * use all of the allotted time (> team03_maxTime ms), returns a
- * pair with position (-2, -2).
+ * Stores a search result in the transposition table, replacing the
+ * same position's entry or else the oldest/shallowest one in its bucket.
+ *
+ * @param key the position key (see `team03_hashKey`)
+ * @param score the score found
+ * @param depth the depth (layers) searched
+ * @param bound TEAM03_TT_EXACT, TEAM03_TT_LOWER or TEAM03_TT_UPPER
+ * @param move the bit index of the best move, or -1 if none
+ */
+void team03_ttStore(uint64_t key, int score, int depth, int bound, int move);
+
+/**
+ * Fills the Zobrist key tables from a fixed seed.
+ */
+void team03_initZobrist(void);
+
+/**
+ * Computes the Zobrist hash of the pieces on the board from scratch.
  *
- * @param state the current board state
- * @param color the current color being considered
- * @param layer the number of layers to search through
- * @param alpha the alpha
- * @param beta the beta
+ * @param state the board state
  *
- * @return the best move
+ * @return the hash
  */
-solvePair_t team03_solveBoard(board_t state, int color, int layer, int alpha, int beta);
+uint64_t team03_hashBoard(board_t state);
 
 /**
- * Statically evaluates all of color's moves for the current board
- * state, outputting a list pairing move positions with their static
- * scores in descending order of value.
- * <br/><br/>
- * If evaluate is 0, instead just gets the moves that are valid.
+ * Gets the transposition table key for a position: the board hash with
+ * the side to move mixed in.
  *
- * @param state the current board state
- * @param color the color to check moves for
- * @param arr a pointer to an array solvePair_t[64]
- * @param evaluate whether to evaluate and sort the move list before returning
- * 
- * @return the result array size, or -1 if any move score was found outside of [min, max]
+ * @param state the board state
+ * @param color the color to move
+ *
+ * @return the key
  */
-int team03_getMoves(board_t state, int color, solvePair_t *arr, int evaluate);
+uint64_t team03_hashKey(board_t state, int color);
 
 
 /*
@@ -367,15 +1569,13 @@ int team03_inBounds(pos_t pos);
 int8_t team03_getIndexByPos(pos_t pos);
 
 /**
- * Computes a bitmask for the move between start and end, inclusive.
- * Assumes they are on the same horizontal, vertical or diagonal axis.
+ * Gets the position for the given flat bit index.
  *
- * @param start the start position of the range
- * @param end the end position of the range
+ * @param ind the bit index, in [0, 63]
  *
- * @return a mask with the bits in the described range asserted
+ * @return the position (row/col) of that bit
  */
-uint64_t team03_getMoveMask(pos_t start, pos_t end);
+pos_t team03_getPosByIndex(int8_t ind);
 
 
 /*
@@ -414,6 +1614,15 @@ void team03_merge(solvePair_t *arr, int lo, int md, int hi);
  */
 long long team03_timeSinceMs(struct timeval start);
 
+/**
+ * Gets the time on a monotonic clock, which (unlike gettimeofday) can't
+ * jump when the system clock is adjusted. Only differences between its
+ * values mean anything.
+ *
+ * @return the current monotonic time in ms
+ */
+long long team03_nowMs(void);
+
 #ifndef TEAM03_IS_POSIX
 /**
  * Portable reimplementation of POSIX <sys/time.h>'s gettimeofday
@@ -445,9 +1654,8 @@ int team03_getTurnNum(board_t state, int color);
  */
 
 /**
- * Checks if the described move is valid. Implementation is identical
- * to `executeMove` except that we break early if any one of the
- * directions we're looking in is a valid flip.
+ * Checks if the described move is valid, i.e. the cell is empty and
+ * playing there would flip at least one piece.
  *
  * @param state the current board state
  * @param pos the position to try playing at
@@ -455,6 +1663,56 @@ int team03_getTurnNum(board_t state, int color);
  */
 int team03_isValidMove(board_t state, pos_t pos, int color);
 
+/**
+ * Computes a mask of every cell the given color can legally play at,
+ * using the move generator picked for this CPU.
+ *
+ * @param state the current board state
+ * @param color the color (0/1) to find moves for
+ *
+ * @return a mask with the bit of every legal move asserted
+ */
+uint64_t team03_getLegalMoves(board_t state, int color);
+
+/**
+ * Scalar legal move generator; computes a mask of every cell the given
+ * color can legally play at. Each of the 8 directions is handled with a
+ * Kogge-Stone (parallel prefix) occluded fill, so the whole board is
+ * done in a fixed number of shifts and masks instead of walking rays
+ * cell by cell.
+ *
+ * @param state the current board state
+ * @param color the color (0/1) to find moves for
+ *
+ * @return a mask with the bit of every legal move asserted
+ */
+uint64_t team03_getLegalMovesScalar(board_t state, int color);
+
+/**
+ * Fills from the given pieces through contiguous runs of propagator bits
+ * towards higher bit indices, in log2(7) doubling steps. Only runs of
+ * length >= 1 are kept, so shifting the result by `shift` once more
+ * gives every cell that caps a run.
+ *
+ * @param gen the generator pieces (the mover's pieces)
+ * @param pro the propagator (opponent pieces, wrap-masked)
+ * @param shift the direction's shift amount (1, 7, 8 or 9)
+ *
+ * @return the cells of every run reachable from a generator
+ */
+uint64_t team03_fillLeft(uint64_t gen, uint64_t pro, int shift);
+
+/**
+ * Same as `team03_fillLeft`, but towards lower bit indices.
+ *
+ * @param gen the generator pieces (the mover's pieces)
+ * @param pro the propagator (opponent pieces, wrap-masked)
+ * @param shift the direction's shift amount (1, 7, 8 or 9)
+ *
+ * @return the cells of every run reachable from a generator
+ */
+uint64_t team03_fillRight(uint64_t gen, uint64_t pro, int shift);
+
 /**
  * Executes the described move, returning the newly updated board state.
  * If the move is not valid, the returned board will equal the original
@@ -469,38 +1727,136 @@ int team03_isValidMove(board_t state, pos_t pos, int color);
 board_t team03_executeMove(board_t state, pos_t pos, int color);
 
 /**
- * Executes part of a move in the given direction. If there is a valid
- * range that would be flipped by this move, modifies the board state
- * to reflect that change.
+ * Computes the mask of opponent pieces that would be flipped by the
+ * described move, using the flip kernel picked for this CPU.
+ * <br/><br/>
+ * Assumes the move cell is empty; returns 0 if the move is invalid.
  *
- * @param state the board state to (maybe) update
- * @param start the position of the move
- * @param color the color being played
- * @param dy row/y component of the direction for this partial move
- * @param dy column/x component of the direction for this partial move
+ * @param state the current board state
+ * @param ind the bit index of the move cell
+ * @param color the color (0/1) of the piece to place
+ *
+ * @return the mask of pieces flipped by the move
  */
-void team03_executeMovePartial(board_t *state, pos_t start, int color, int8_t dy, int8_t dx);
+uint64_t team03_computeFlips(board_t state, int8_t ind, int color);
 
 /**
- * Flips the pieces between the provided start and end positions, inclusive.
- * Assumes all pieces in the range are present.
+ * Scalar flip kernel; computes the mask of opponent pieces that would
+ * be flipped by the described move. Each direction looks up the ray
+ * from the move cell, finds the first cell that isn't an opponent piece
+ * and keeps the run before it only if that cell is one of ours.
+ * <br/><br/>
+ * Assumes the move cell is empty; returns 0 if the move is invalid.
  *
- * @param state the board state to update
- * @param start the start position of the run to flip
- * @param end the end position of the run to flip
+ * @param state the current board state
+ * @param ind the bit index of the move cell
+ * @param color the color (0/1) of the piece to place
+ *
+ * @return the mask of pieces flipped by the move
  */
-void team03_flipPieces(board_t *state, pos_t start, pos_t end);
+uint64_t team03_computeFlipsScalar(board_t state, int8_t ind, int color);
 
+#ifdef TEAM03_IS_X86
 /**
- * Sets the pieces between the provided start and end positions, inclusive,
- * to the desired color. Also places pieces if any cells in range are empty.
+ * BMI2 flip kernel. For each of the 4 lines through the move cell, PEXT
+ * packs the line into an 8-bit index, two small table lookups give the
+ * flipped cells within the line and PDEP scatters them back.
+ * <br/><br/>
+ * Assumes the move cell is empty; returns 0 if the move is invalid.
  *
- * @param state the board state to update
- * @param start the start position of the run to set
- * @param end the end position of the run to set
- * @param color the color to set the pieces to
+ * @param state the current board state
+ * @param ind the bit index of the move cell
+ * @param color the color (0/1) of the piece to place
+ *
+ * @return the mask of pieces flipped by the move
+ */
+TEAM03_TARGET("bmi2")
+uint64_t team03_computeFlipsPEXT(board_t state, int8_t ind, int color);
+
+/**
+ * AVX2 legal move generator. Same Kogge-Stone fill as the scalar version,
+ * but the four direction pairs (E/W, S/N, SW/NE, SE/NW) each get a 64-bit
+ * lane, so one left-shifting and one right-shifting vector cover all 8.
+ *
+ * @param state the current board state
+ * @param color the color (0/1) to find moves for
+ *
+ * @return a mask with the bit of every legal move asserted
+ */
+TEAM03_TARGET("avx2")
+uint64_t team03_getLegalMovesAVX2(board_t state, int color);
+
+/**
+ * The AVX2 move generator's fills: every cell that caps a run of
+ * opponent pieces from one of ours, in each lane's pair of directions.
+ *
+ * @param own the mover's pieces, in every lane
+ * @param opp the opponent's pieces, in every lane
+ *
+ * @return each lane's capping cells (empty or not)
+ */
+TEAM03_TARGET("avx2")
+__m256i team03_fillMovesAVX2(__m256i own, __m256i opp);
+
+/**
+ * AVX2 flip kernel. Fills from the move cell through opponent pieces in
+ * all 8 directions at once (4 lanes x 2 shift directions) and keeps each
+ * lane's run only if the cell after it is one of ours.
+ * <br/><br/>
+ * Assumes the move cell is empty; returns 0 if the move is invalid.
+ *
+ * @param state the current board state
+ * @param ind the bit index of the move cell
+ * @param color the color (0/1) of the piece to place
+ *
+ * @return the mask of pieces flipped by the move
+ */
+TEAM03_TARGET("avx2")
+uint64_t team03_computeFlipsAVX2(board_t state, int8_t ind, int color);
+
+/**
+ * ORs together the four 64-bit lanes of a vector.
+ *
+ * @param vec the vector to reduce
+ *
+ * @return the OR of all four lanes
+ */
+TEAM03_TARGET("avx2")
+uint64_t team03_reduceOr(__m256i vec);
+
+/**
+ * AVX2 mobility kernel; the AVX2 move generator plus a POPCNT.
+ *
+ * @param state the current board state
+ * @param color the color to consider moves for
+ *
+ * @return the number of valid moves that the color can take
+ */
+TEAM03_TARGET("avx2,popcnt")
+int team03_computeMobilityAVX2(board_t state, int color);
+
+/**
+ * AVX2 mobility advantage kernel. Both sides' fills are independent, so
+ * running them together lets each hide the other's latency.
+ *
+ * @param state the current board state
+ * @param color the color to consider moves for
+ *
+ * @return the difference in the number of valid moves
+ */
+TEAM03_TARGET("avx2,popcnt")
+int team03_computeMobilityDiffAVX2(board_t state, int color);
+#endif // TEAM03_IS_X86
+
+/**
+ * Fills the per-square direction ray table used by `computeFlips`.
+ */
+void team03_initRays(void);
+
+/**
+ * Fills the line tables used by the PEXT flip kernel.
  */
-void team03_setPieces(board_t *state, pos_t start, pos_t end, int color);
+void team03_initLines(void);
 
 /**
  * Create pair of position and score to return from recursive solve function.
@@ -566,17 +1922,56 @@ int team03_getBitAt(uint64_t mask, pos_t pos);
 void team03_setBitAt(uint64_t *mask, pos_t pos, int value);
 
 /**
- * Creates a mask with a range of bits between `start` and `end` asserted.
+ * Finds the index of the highest set bit in the given integer.
+ * The result is undefined if `num` is 0.
  *
- * @param start the start (from bit 0->) of the range to assert
- * @param offset the (inclusive) end of the range to assert
+ * @param num the integer
  *
- * @return the described mask
+ * @return the index of the highest bit that is on in `num`
+ */
+int team03_bitScanReverse(uint64_t num);
+
+/**
+ * Finds the index of the lowest set bit in the given integer.
+ * The result is undefined if `num` is 0.
+ *
+ * @param num the integer
+ *
+ * @return the index of the lowest bit that is on in `num`
+ */
+int team03_bitScan(uint64_t num);
+
+/**
+ * Flips a bitboard vertically (row 0 <-> row 7).
+ *
+ * @param x the bitboard
+ *
+ * @return the flipped bitboard
+ */
+uint64_t team03_flipVertical(uint64_t x);
+
+/**
+ * Mirrors a bitboard horizontally (column 0 <-> column 7).
+ *
+ * @param x the bitboard
+ *
+ * @return the mirrored bitboard
+ */
+uint64_t team03_mirrorHorizontal(uint64_t x);
+
+/**
+ * Flips a bitboard about its main diagonal (index 0 to 63), swapping rows
+ * and columns.
+ *
+ * @param x the bitboard
+ *
+ * @return the flipped bitboard
  */
-uint64_t team03_rangeMask(int8_t start, int8_t end);
+uint64_t team03_flipDiagonal(uint64_t x);
 
 /**
- * Counts the number of set bits in the given integer.
+ * Counts the number of set bits in the given integer, using the popcount
+ * kernel picked for this CPU.
  *
  * @param num the integer
  *
@@ -584,4 +1979,40 @@ uint64_t team03_rangeMask(int8_t start, int8_t end);
  */
 int team03_popcount(uint64_t num);
 
+/**
+ * Portable popcount kernel; counts the number of set bits in the given
+ * integer without assuming the POPCNT instruction.
+ *
+ * @param num the integer
+ *
+ * @return the number of bits that are on in `num`
+ */
+int team03_popcountScalar(uint64_t num);
+
+#ifdef TEAM03_IS_X86
+/**
+ * POPCNT popcount kernel; a single instruction.
+ *
+ * @param num the integer
+ *
+ * @return the number of bits that are on in `num`
+ */
+TEAM03_TARGET("popcnt")
+int team03_popcountPOPCNT(uint64_t num);
+#endif // TEAM03_IS_X86
+
+
+/*
+ **********************
+ * ISA dispatch       *
+ **********************
+ */
+
+/**
+ * Picks the fastest variant of each board kernel that this CPU supports,
+ * from CPUID. Called once at startup by `team03_init`; until then the
+ * scalar kernels are used.
+ */
+void team03_initKernels(void);
+
 #endif // TEAM03_H
@@ -0,0 +1,6 @@
+#!/bin/sh
+# Builds the offline tools against the bot; run from the repo root
+gcc ${CFLAGS} -O2 -pthread -o speedup tools/speedup.c src/team03.c src/reversi_functions.c
+gcc ${CFLAGS} -O2 -pthread -o selfplay tools/selfplay.c tools/positions.c src/team03.c src/reversi_functions.c rivals/teamnaive.c rivals/teamrand.c
+gcc ${CFLAGS} -O2 -pthread -o tune tools/tune.c tools/positions.c src/team03.c src/reversi_functions.c -lm
+gcc ${CFLAGS} -O2 -pthread -o check tools/check.c src/team03.c src/reversi_functions.c
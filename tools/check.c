@@ -0,0 +1,256 @@
+/*
+ * COP3502H Final Project
+ * Team 03
+ * Erick + Benjamin
+ *
+ * Consistency check for the board kernels and the endgame solver. Plays
+ * random games (fixed seed) and, at every position, compares the kernel
+ * picked for this CPU and every other variant it supports against the
+ * scalar one, the scalar move generator and flips against the reference
+ * game code, and the incrementally updated patterns against a full
+ * recompute. Then it solves random positions with a few empties left,
+ * with full and random windows, and compares the scores against a plain
+ * minimax of the whole tree. Stops at the first mismatch.
+ *
+ * Usage: ./check [games] [endgame positions] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/team03.h"
+
+#define CHECK_MIN_EMPTIES 4 // endgame positions range over these empties
+#define CHECK_MAX_EMPTIES 10
+
+// Which ISA variants this CPU can run, besides the scalar kernels
+int check_hasPopcnt = 0, check_hasAVX2 = 0, check_hasBMI2 = 0;
+long long check_count = 0;
+
+/**
+ * Compares a kernel's result against the expected one, and exits with
+ * the position if they differ.
+ *
+ * @param what the kernel and the input it was given
+ * @param state the position being checked
+ * @param color the color to move
+ * @param got the kernel's result
+ * @param want the expected result
+ */
+void check_equal(const char *what, board_t state, int color, long long got, long long want) {
+    check_count++;
+    if (got == want) return;
+    printf("MISMATCH in %s (%s to move): got %lld (%llx), expected %lld (%llx)\n", what, color ? "white" : "black",
+           got, (unsigned long long) got, want, (unsigned long long) want);
+    team03_print(state);
+    exit(1);
+}
+
+/**
+ * Checks every kernel on a position, and the move generator and flips
+ * against the reference game code.
+ *
+ * @param state the position
+ * @param color the color to move
+ * @param board the same position as a reference board
+ */
+void check_kernels(board_t state, int color, const enum piece board[][SIZE]) {
+    uint64_t own = team03_getPieces(state, color), masks[3] = { state.on, state.color, own };
+    for (int i = 0; i < 3; i++) {
+        int want = team03_popcountScalar(masks[i]);
+        check_equal("popcount", state, color, team03_popcount(masks[i]), want);
+#ifdef TEAM03_IS_X86
+        if (check_hasPopcnt) check_equal("popcount (POPCNT)", state, color, team03_popcountPOPCNT(masks[i]), want);
+#endif
+    }
+
+    // Move generators
+    uint64_t legal = team03_getLegalMovesScalar(state, color);
+    check_equal("legal moves", state, color, (long long) team03_getLegalMoves(state, color), (long long) legal);
+#ifdef TEAM03_IS_X86
+    if (check_hasAVX2)
+        check_equal("legal moves (AVX2)", state, color, (long long) team03_getLegalMovesAVX2(state, color), (long long) legal);
+#endif
+
+    // Flips on every empty square (0 where the move isn't legal), and the
+    // moves themselves against the reference board
+    enum piece mine = color ? WHITE : BLACK;
+    for (int8_t ind = 0; ind < 64; ind++) {
+        if (state.on >> ind & 1) continue;
+        pos_t pos = team03_getPosByIndex(ind);
+        position ref = { pos.y, pos.x };
+        check_equal("legal moves (reference)", state, color, (long long) (legal >> ind & 1),
+                    isValidMove(board, &ref, mine) ? 1 : 0);
+
+        uint64_t flips = team03_computeFlipsScalar(state, ind, color);
+        check_equal("flips (legal)", state, color, flips != 0, (long long) (legal >> ind & 1));
+        check_equal("flips", state, color, (long long) team03_computeFlips(state, ind, color), (long long) flips);
+#ifdef TEAM03_IS_X86
+        if (check_hasBMI2)
+            check_equal("flips (PEXT)", state, color, (long long) team03_computeFlipsPEXT(state, ind, color), (long long) flips);
+        if (check_hasAVX2)
+            check_equal("flips (AVX2)", state, color, (long long) team03_computeFlipsAVX2(state, ind, color), (long long) flips);
+#endif
+        if (!flips) continue;
+
+        enum piece after[SIZE][SIZE];
+        memcpy(after, board, sizeof(after));
+        executeMove(after, &ref, mine);
+        board_t want = team03_loadBoard((const enum piece (*)[SIZE]) after), got = team03_executeMove(state, pos, color);
+        check_equal("move (discs)", state, color, (long long) got.on, (long long) want.on);
+        check_equal("move (colors)", state, color, (long long) got.color, (long long) want.color);
+        check_equal("move (hash)", state, color, (long long) got.hash, (long long) want.hash);
+    }
+
+    // Mobility, for each side
+    for (int side = 0; side < 2; side++) {
+        int want = team03_computeMobilityScalar(state, side);
+        check_equal("mobility (scalar)", state, color, want, team03_popcountScalar(team03_getLegalMovesScalar(state, side)));
+        check_equal("mobility", state, color, team03_computeMobility(state, side), want);
+        int diff = team03_computeMobilityDiffScalar(state, side);
+        check_equal("mobility diff", state, color, team03_computeMobilityDiff(state, side), diff);
+#ifdef TEAM03_IS_X86
+        if (check_hasAVX2 && check_hasPopcnt) {
+            check_equal("mobility (AVX2)", state, color, team03_computeMobilityAVX2(state, side), want);
+            check_equal("mobility diff (AVX2)", state, color, team03_computeMobilityDiffAVX2(state, side), diff);
+        }
+#endif
+    }
+
+    // Pattern sums, in every phase
+    team03_patterns_t patterns;
+    team03_computePatterns(&patterns, state);
+    for (int phase = 0; phase < TEAM03_EVAL_PHASES; phase++) {
+        int want = team03_sumPatternsScalar(team03_evalTable[phase], patterns.indices);
+        check_equal("pattern sum", state, color, team03_evaluatePatterns(state, phase), want);
+#ifdef TEAM03_IS_X86
+        if (check_hasAVX2)
+            check_equal("pattern sum (AVX2)", state, color, team03_sumPatternsAVX2(team03_evalTable[phase], patterns.indices), want);
+#endif
+    }
+}
+
+/**
+ * Plays random games, checking the kernels at every position and the
+ * incremental pattern update after every move.
+ *
+ * @param games the number of games
+ */
+void check_games(int games) {
+    for (int game = 0; game < games; game++) {
+        enum piece board[SIZE][SIZE];
+        initBoard(board);
+        board_t state = team03_loadBoard((const enum piece (*)[SIZE]) board);
+        team03_patterns_t patterns;
+        team03_computePatterns(&patterns, state);
+        int color = 0;
+
+        for (;;) {
+            check_kernels(state, color, (const enum piece (*)[SIZE]) board);
+            solvePair_t moves[64];
+            int num = team03_getMoves(state, color, moves, 0);
+            if (!num && !(num = team03_getMoves(state, color ^= 1, moves, 0))) break;
+
+            // Play the same move on both boards
+            pos_t pos = moves[rand() % num].pos;
+            position ref = { pos.y, pos.x };
+            executeMove(board, &ref, color ? WHITE : BLACK);
+            state = team03_executeMove(state, pos, color);
+            color ^= 1;
+
+            team03_patterns_t updated, full;
+            team03_updatePatterns(&updated, &patterns, state);
+            team03_computePatterns(&full, state);
+            for (int i = 0; i < TEAM03_PATTERNS; i++)
+                check_equal("pattern update", state, color, updated.indices[i], full.indices[i]);
+            patterns = updated;
+        }
+    }
+}
+
+/**
+ * Plain minimax over the whole game tree, with the scalar kernels.
+ *
+ * @param state the position
+ * @param color the color to move
+ * @param passed whether the last move was a pass
+ *
+ * @return the final disc differential with perfect play, for color
+ */
+int check_minimax(board_t state, int color, int passed) {
+    uint64_t moves = team03_getLegalMovesScalar(state, color);
+    if (!moves) return passed ? team03_finalScore(state, color) : 0 - check_minimax(state, !color, 1);
+
+    int best = -65;
+    for (; moves; moves &= moves - 1) {
+        int8_t ind = (int8_t) team03_bitScan(moves);
+        int score = 0 - check_minimax(team03_executeMove(state, team03_getPosByIndex(ind), color), !color, 0);
+        if (score > best) best = score;
+    }
+    return best;
+}
+
+/**
+ * Solves random endgame positions with the solver, with the full window
+ * and a random one, and checks the scores against minimax.
+ *
+ * @param count the number of positions
+ */
+void check_endgames(int count) {
+    for (int n = 0; n < count; n++) {
+        // Play a random game down to the number of empties
+        int empties = CHECK_MIN_EMPTIES + n % (CHECK_MAX_EMPTIES - CHECK_MIN_EMPTIES + 1);
+        enum piece board[SIZE][SIZE];
+        initBoard(board);
+        board_t state = team03_loadBoard((const enum piece (*)[SIZE]) board);
+        int color = 0, passes = 0;
+        while (64 - team03_popcount(state.on) > empties && passes < 2) {
+            solvePair_t moves[64];
+            int num = team03_getMoves(state, color, moves, 0);
+            passes = num ? 0 : passes + 1;
+            if (num) state = team03_executeMove(state, moves[rand() % num].pos, color);
+            color ^= 1;
+        }
+        if (passes == 2) {
+            n--; // the game ended early; try another
+            continue;
+        }
+        int want = check_minimax(state, color, 0);
+
+        // The solver fails soft: outside the window, the score only bounds
+        // the true one
+        team03_endgame_t eg;
+        int parity = team03_initEmpties(&eg, state);
+        solvePair_t full = team03_solveEndgame(&eg, state, color, -64, 64, empties, parity, 0);
+        check_equal("endgame solve", state, color, full.score, want);
+        int alpha = rand() % 129 - 64, beta = alpha + 1 + rand() % 8;
+        parity = team03_initEmpties(&eg, state);
+        int score = team03_solveEndgame(&eg, state, color, alpha, beta, empties, parity, 0).score;
+        if (score <= alpha) check_equal("endgame solve (fail low)", state, color, want <= score, 1);
+        else if (score >= beta) check_equal("endgame solve (fail high)", state, color, want >= score, 1);
+        else check_equal("endgame solve (window)", state, color, score, want);
+    }
+}
+
+int main(int argc, char **argv) {
+    int games = argc > 1 ? atoi(argv[1]) : 2000;
+    int endgames = argc > 2 ? atoi(argv[2]) : 700;
+    srand(argc > 3 ? atoi(argv[3]) : 3502);
+    team03_init();
+#ifdef TEAM03_IS_X86
+    __builtin_cpu_init();
+    check_hasPopcnt = __builtin_cpu_supports("popcnt");
+    check_hasAVX2 = __builtin_cpu_supports("avx2");
+    check_hasBMI2 = __builtin_cpu_supports("bmi2");
+#endif
+    printf("Kernels: scalar%s%s%s\n", check_hasPopcnt ? ", POPCNT" : "", check_hasAVX2 ? ", AVX2" : "",
+           check_hasBMI2 ? ", PEXT" : "");
+
+    check_games(games);
+    printf("%d games: %lld kernel checks passed\n", games, check_count);
+    check_count = 0;
+    check_endgames(endgames);
+    printf("%d endgames (%d-%d empties): %lld solves match minimax\n", endgames,
+           CHECK_MIN_EMPTIES, CHECK_MAX_EMPTIES, check_count);
+    return 0;
+}
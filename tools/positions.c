@@ -0,0 +1,73 @@
+/*
+ * COP3502H Final Project
+ * Team 03
+ * Erick + Benjamin
+ *
+ * Labelled training positions; see positions.h for the format.
+ */
+
+#include "positions.h"
+
+/**
+ * Packs a record into its on-disk form.
+ *
+ * @param rec the record
+ * @param out the TEAM03_RECORD_BYTES bytes to write to
+ */
+void team03_packRecord(const team03_record_t *rec, unsigned char *out) {
+    for (int i = 0; i < 8; i++) {
+        out[i] = (unsigned char) (rec->black >> (8 * i));
+        out[8 + i] = (unsigned char) (rec->white >> (8 * i));
+    }
+    out[16] = (unsigned char) (rec->label & 0xff);
+    out[17] = (unsigned char) ((rec->label >> 8) & 0xff);
+    out[18] = (unsigned char) (rec->result & 0xff);
+    out[19] = (unsigned char) rec->flags;
+}
+
+/**
+ * Unpacks a record from its on-disk form.
+ *
+ * @param in the TEAM03_RECORD_BYTES bytes to read
+ * @param rec the record to fill in
+ */
+void team03_unpackRecord(const unsigned char *in, team03_record_t *rec) {
+    rec->black = rec->white = 0;
+    for (int i = 0; i < 8; i++) {
+        rec->black |= (uint64_t) in[i] << (8 * i);
+        rec->white |= (uint64_t) in[8 + i] << (8 * i);
+    }
+    rec->label = (short) (in[16] | (in[17] << 8));
+    rec->result = (signed char) in[18];
+    rec->flags = in[19];
+}
+
+/**
+ * Reads the next record from a file.
+ *
+ * @param file the file
+ * @param rec the record to fill in
+ *
+ * @return 1 if a record was read, 0 at the end of the file
+ */
+int team03_readRecord(FILE *file, team03_record_t *rec) {
+    unsigned char buf[TEAM03_RECORD_BYTES];
+    if (fread(buf, TEAM03_RECORD_BYTES, 1, file) != 1) return 0;
+    team03_unpackRecord(buf, rec);
+    return 1;
+}
+
+/**
+ * Builds the board state for a record.
+ *
+ * @param rec the record
+ *
+ * @return the board state, with its hash
+ */
+board_t team03_recordBoard(const team03_record_t *rec) {
+    board_t state;
+    state.on = rec->black | rec->white;
+    state.color = rec->white;
+    state.hash = team03_hashBoard(state);
+    return state;
+}
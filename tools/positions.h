@@ -0,0 +1,75 @@
+/*
+ * COP3502H Final Project
+ * Team 03
+ * Erick + Benjamin
+ *
+ * Labelled training positions, as written by the self-play generator and
+ * read by the weight tuner.
+ *
+ * Each record is TEAM03_RECORD_BYTES bytes, little-endian:
+ *   0-7    black discs (bitboard, index = y * 8 + x)
+ *   8-15   white discs
+ *   16-17  label: the position's score in eighths of a disc, from
+ *          black's point of view (int16)
+ *   18     final disc differential of the game, from black's point of
+ *          view (int8)
+ *   19     flags: TEAM03_RECORD_WHITE if white is to move,
+ *          TEAM03_RECORD_EXACT if the label is an exact endgame solve
+ */
+
+#ifndef TEAM03_POSITIONS_H
+#define TEAM03_POSITIONS_H
+
+#include <stdio.h>
+#include "../src/team03.h"
+
+#define TEAM03_RECORD_BYTES 20
+#define TEAM03_RECORD_WHITE 1
+#define TEAM03_RECORD_EXACT 2
+
+/**
+ * A labelled position.
+ */
+typedef struct team03_record {
+    uint64_t black, white;
+    int label; // eighths of a disc, black's point of view
+    int result; // final disc differential, black's point of view
+    int flags;
+} team03_record_t;
+
+/**
+ * Packs a record into its on-disk form.
+ *
+ * @param rec the record
+ * @param out the TEAM03_RECORD_BYTES bytes to write to
+ */
+void team03_packRecord(const team03_record_t *rec, unsigned char *out);
+
+/**
+ * Unpacks a record from its on-disk form.
+ *
+ * @param in the TEAM03_RECORD_BYTES bytes to read
+ * @param rec the record to fill in
+ */
+void team03_unpackRecord(const unsigned char *in, team03_record_t *rec);
+
+/**
+ * Reads the next record from a file.
+ *
+ * @param file the file
+ * @param rec the record to fill in
+ *
+ * @return 1 if a record was read, 0 at the end of the file
+ */
+int team03_readRecord(FILE *file, team03_record_t *rec);
+
+/**
+ * Builds the board state for a record.
+ *
+ * @param rec the record
+ *
+ * @return the board state, with its hash
+ */
+board_t team03_recordBoard(const team03_record_t *rec);
+
+#endif // TEAM03_POSITIONS_H
@@ -0,0 +1,273 @@
+/*
+ * COP3502H Final Project
+ * Team 03
+ * Erick + Benjamin
+ *
+ * Self-play data generator for fitting the evaluation weights. Every core
+ * runs its own game at a time: a random opening, then each side is played
+ * by the bot's fixed-depth search or one of the rivals (with the odd
+ * random move thrown in). Every position after the opening is labelled
+ * with the bot's search score at a fixed depth, or the exact score once
+ * it's close enough to the end, and positions we've already got (by hash)
+ * are skipped. Records are appended to the output file; see positions.h.
+ *
+ * Usage: ./selfplay <games> <file> [depth] [exact empties] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "positions.h"
+#include "../rivals/teamnaive.h"
+#include "../rivals/teamrand.h"
+
+#define SELFPLAY_MAX_WORKERS 64 // the bot's per-thread tables hold 64
+#define SELFPLAY_MIN_OPENING 6 // random plies at the start of each game
+#define SELFPLAY_MAX_OPENING 20
+#define SELFPLAY_RANDOM_MOVES 10 // % of later moves that are random
+
+// Players for each side of a game
+#define SELFPLAY_BOT 0
+#define SELFPLAY_NAIVE 1
+#define SELFPLAY_RAND 2
+
+// Run settings and shared state; `selfplay_lock` guards everything below it
+int selfplay_games, selfplay_depth, selfplay_exactEmpties, selfplay_numWorkers;
+unsigned long long selfplay_seed;
+FILE *selfplay_out;
+pthread_mutex_t selfplay_lock = PTHREAD_MUTEX_INITIALIZER;
+int selfplay_nextGame = 0;
+long long selfplay_labelled = 0, selfplay_written = 0;
+uint64_t *selfplay_seen = NULL; // open addressing hash set of position keys
+size_t selfplay_seenMask = 0, selfplay_seenCount = 0;
+
+/**
+ * Advances a worker's random number generator (xorshift64).
+ *
+ * @param state the generator state
+ *
+ * @return the next random number
+ */
+uint64_t selfplay_random(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+/**
+ * Adds a position key to the set of positions we've seen, growing it as
+ * needed. The caller holds `selfplay_lock`.
+ *
+ * @param key the position key (never 0)
+ *
+ * @return 1 if the key is new, 0 if we've seen it
+ */
+int selfplay_insert(uint64_t key) {
+    if (2 * (selfplay_seenCount + 1) > selfplay_seenMask + 1) {
+        // Double the table and re-insert everything
+        size_t oldSize = selfplay_seen ? selfplay_seenMask + 1 : 0;
+        uint64_t *old = selfplay_seen;
+        selfplay_seenMask = oldSize ? 2 * oldSize - 1 : (1 << 16) - 1;
+        selfplay_seen = calloc(selfplay_seenMask + 1, sizeof(uint64_t));
+        if (!selfplay_seen) {
+            fprintf(stderr, "Out of memory growing the position table to %zu entries\n",
+                    (size_t) selfplay_seenMask + 1);
+            exit(1);
+        }
+        for (size_t i = 0; i < oldSize; i++) {
+            if (!old[i]) continue;
+            size_t j = old[i] & selfplay_seenMask;
+            while (selfplay_seen[j]) j = (j + 1) & selfplay_seenMask;
+            selfplay_seen[j] = old[i];
+        }
+        free(old);
+    }
+    
+    size_t i = key & selfplay_seenMask;
+    for (; selfplay_seen[i]; i = (i + 1) & selfplay_seenMask)
+        if (selfplay_seen[i] == key) return 0;
+    selfplay_seen[i] = key;
+    selfplay_seenCount++;
+    return 1;
+}
+
+/**
+ * Gets a record's key for the seen set: its hash with the side to move.
+ *
+ * @param rec the record
+ *
+ * @return the key (never 0)
+ */
+uint64_t selfplay_key(const team03_record_t *rec) {
+    uint64_t key = team03_hashKey(team03_recordBoard(rec), rec->flags & TEAM03_RECORD_WHITE);
+    return key ? key : 1;
+}
+
+/**
+ * Labels a position: the exact score if it has few enough empties,
+ * otherwise the bot's search score at the fixed depth.
+ *
+ * @param state the board state
+ * @param color the color to move (with at least one move)
+ * @param rec the record to fill in (not the result)
+ *
+ * @return the best move found
+ */
+pos_t selfplay_label(board_t state, int color, team03_record_t *rec) {
+    solvePair_t moveList[64];
+    int num = team03_getMoves(state, color, moveList, 1);
+    int empties = 64 - team03_popcount(state.on), score;
+    pos_t pos = moveList[0].pos;
+    
+    rec->black = state.on & ~state.color;
+    rec->white = state.color;
+    rec->flags = color ? TEAM03_RECORD_WHITE : 0;
+    if (empties <= selfplay_exactEmpties) {
+        solvePair_t res = team03_solveEndgameRoot(state, color, moveList, num, -65, 65);
+        score = res.score * 8, pos = res.pos;
+        rec->flags |= TEAM03_RECORD_EXACT;
+    } else {
+        for (int layers = 1; layers <= selfplay_depth; layers++)
+            pos = team03_searchRoot(state, color, moveList, num, layers, -1e9, 1e9);
+        score = moveList[0].score;
+    }
+    
+    // Labels are from black's point of view, and have to fit an int16
+    if (color) score = 0 - score;
+    rec->label = score < -32767 ? -32767 : score > 32767 ? 32767 : score;
+    return pos;
+}
+
+/**
+ * Plays one game, labelling every position after the opening.
+ *
+ * @param rng the worker's random number generator
+ * @param recs the records to fill in (up to 64)
+ *
+ * @return the number of records
+ */
+int selfplay_game(uint64_t *rng, team03_record_t *recs) {
+    enum piece board[SIZE][SIZE];
+    initBoard(board);
+    board_t state = team03_loadBoard((const enum piece (*)[SIZE]) board);
+    int color = 0, num = 0, passes = 0;
+    
+    // The bot plays most sides; the rivals add some variety
+    int players[2], opening = SELFPLAY_MIN_OPENING
+                              + (int) (selfplay_random(rng) % (SELFPLAY_MAX_OPENING - SELFPLAY_MIN_OPENING + 1));
+    for (int i = 0; i < 2; i++) {
+        int r = (int) (selfplay_random(rng) % 10);
+        players[i] = (r < 7) ? SELFPLAY_BOT : (r < 9) ? SELFPLAY_NAIVE : SELFPLAY_RAND;
+    }
+    
+    for (int ply = 0; passes < 2; ply++) {
+        solvePair_t moves[64];
+        int numMoves = team03_getMoves(state, color, moves, 0);
+        if (!numMoves) {
+            passes++, color ^= 1;
+            continue;
+        }
+        passes = 0;
+        
+        // Label the position; the bot just plays the labelling search's move
+        pos_t pos = moves[selfplay_random(rng) % numMoves].pos;
+        if (ply >= opening) {
+            pos_t best = selfplay_label(state, color, &recs[num++]);
+            if ((int) (selfplay_random(rng) % 100) >= SELFPLAY_RANDOM_MOVES) {
+                if (players[color] == SELFPLAY_BOT) pos = best;
+                else if (players[color] == SELFPLAY_NAIVE) pos = teamnaive_getMove(state, color, 0);
+                else pos = teamrand_getMove(state, color, 0);
+            }
+        }
+        
+        // Fall back on the first legal move if a rival picked an illegal one
+        board_t next = team03_executeMove(state, pos, color);
+        state = (next.on != state.on) ? next : team03_executeMove(state, moves[0].pos, color);
+        color ^= 1;
+    }
+    
+    int result = team03_count(state, 0) - team03_count(state, 1);
+    for (int i = 0; i < num; i++) recs[i].result = result;
+    return num;
+}
+
+/**
+ * Entry point for a worker thread: plays games until there are none
+ * left, writing out the positions we haven't seen yet after each one.
+ *
+ * @param arg the worker's id, as an intptr
+ *
+ * @return NULL
+ */
+void *selfplay_worker(void *arg) {
+    team03_threadId = (int) (size_t) arg;
+    uint64_t rng = selfplay_seed * 0x9e3779b97f4a7c15ull + (uint64_t) team03_threadId + 1;
+    team03_record_t recs[64];
+    unsigned char buf[TEAM03_RECORD_BYTES];
+    
+    for (;;) {
+        pthread_mutex_lock(&selfplay_lock);
+        int game = selfplay_nextGame++;
+        pthread_mutex_unlock(&selfplay_lock);
+        if (game >= selfplay_games) break;
+        
+        int num = selfplay_game(&rng, recs);
+        pthread_mutex_lock(&selfplay_lock);
+        selfplay_labelled += num;
+        for (int i = 0; i < num; i++) {
+            if (!selfplay_insert(selfplay_key(&recs[i]))) continue;
+            team03_packRecord(&recs[i], buf);
+            fwrite(buf, TEAM03_RECORD_BYTES, 1, selfplay_out);
+            selfplay_written++;
+        }
+        pthread_mutex_unlock(&selfplay_lock);
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <games> <file> [depth] [exact empties] [seed]\n", argv[0]);
+        return 1;
+    }
+    selfplay_games = atoi(argv[1]);
+    selfplay_depth = argc > 3 ? atoi(argv[3]) : 4;
+    selfplay_exactEmpties = argc > 4 ? atoi(argv[4]) : 14;
+    selfplay_seed = argc > 5 ? strtoull(argv[5], NULL, 10) : 3502;
+    team03_init();
+    
+    // Positions already in the file count as selfplay_seen
+    long long existing = 0;
+    FILE *in = fopen(argv[2], "rb");
+    if (in) {
+        team03_record_t rec;
+        for (; team03_readRecord(in, &rec); existing++) selfplay_insert(selfplay_key(&rec));
+        fclose(in);
+    }
+    if (!(selfplay_out = fopen(argv[2], "ab"))) {
+        perror(argv[2]);
+        return 1;
+    }
+    
+    // One worker per core
+    selfplay_numWorkers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (selfplay_numWorkers < 1) selfplay_numWorkers = 1;
+    if (selfplay_numWorkers > SELFPLAY_MAX_WORKERS) selfplay_numWorkers = SELFPLAY_MAX_WORKERS;
+    fprintf(stderr, "%d games on %d workers, depth %d, exact from %d empties (%lld positions already)\n",
+            selfplay_games, selfplay_numWorkers, selfplay_depth, selfplay_exactEmpties, existing);
+    
+    long long start = team03_nowMs();
+    pthread_t threads[SELFPLAY_MAX_WORKERS];
+    for (int i = 0; i < selfplay_numWorkers; i++) pthread_create(&threads[i], NULL, selfplay_worker, (void *) (size_t) i);
+    for (int i = 0; i < selfplay_numWorkers; i++) pthread_join(threads[i], NULL);
+    long long took = team03_nowMs() - start;
+    fclose(selfplay_out);
+    
+    double seconds = (took ? took : 1) / 1000.0;
+    fprintf(stderr, "%lld positions labelled, %lld new, in %.1f s: %.1f positions/s/core\n",
+            selfplay_labelled, selfplay_written, seconds, selfplay_labelled / seconds / selfplay_numWorkers);
+    return 0;
+}
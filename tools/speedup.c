@@ -0,0 +1,65 @@
+/*
+ * COP3502H Final Project
+ * Team 03
+ * Erick + Benjamin
+ *
+ * Parallel search speedup report. Plays a few random opening moves from
+ * the start position (fixed seed) and prints how the selected parallel
+ * backend scales with 1-16 threads on the resulting positions, then does
+ * the same for the exact solve of a random endgame position.
+ *
+ * Usage: ./speedup [depth] [lazy|ybwc] [endgame empties]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../src/team03.h"
+
+#define SPEEDUP_ENDGAME_EMPTIES 18
+
+/**
+ * Plays random moves from the start position until the given number of
+ * empties is left, passing when a side has no moves.
+ *
+ * @param empties the empties to stop at
+ * @param color set to the color to move (one with moves, if either has)
+ *
+ * @return the position reached
+ */
+board_t speedup_randomPosition(int empties, int *color) {
+    enum piece board[SIZE][SIZE];
+    initBoard(board);
+    board_t state = team03_loadBoard((const enum piece (*)[SIZE]) board);
+    int passes = 0;
+    *color = 0;
+    while (64 - team03_popcount(state.on) > empties && passes < 2) {
+        solvePair_t moves[64];
+        int num = team03_getMoves(state, *color, moves, 0);
+        passes = num ? 0 : passes + 1;
+        if (num) state = team03_executeMove(state, moves[rand() % num].pos, *color);
+        *color ^= 1;
+    }
+    
+    solvePair_t moves[64];
+    if (!team03_getMoves(state, *color, moves, 0)) *color ^= 1;
+    return state;
+}
+
+int main(int argc, char **argv) {
+    int depth = argc > 1 ? atoi(argv[1]) : 10;
+    int empties = argc > 3 ? atoi(argv[3]) : SPEEDUP_ENDGAME_EMPTIES;
+    team03_init();
+    if (argc > 2) team03_parallel = team03_equalsIgnoreCase(argv[2], "ybwc") ? TEAM03_PARALLEL_YBWC : TEAM03_PARALLEL_LAZY;
+    
+    // A handful of midgame positions from random openings, then an endgame
+    srand(3502);
+    for (int game = 0; game < 4; game++) {
+        int color;
+        board_t state = speedup_randomPosition(game < 3 ? 40 : empties, &color);
+        printf("Position %d:\n", game + 1);
+        team03_print(state);
+        team03_reportSpeedup(state, color, depth, stdout);
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,289 @@
+/*
+ * COP3502H Final Project
+ * Team 03
+ * Erick + Benjamin
+ *
+ * Offline tuner for the evaluation weights: fits the pattern tables and
+ * the mobility, parity and stability weights (for every phase) to the
+ * self-play labels by least squares, with AdaGrad steps on
+ * mini-batches. The data is streamed from the file a batch at a time,
+ * each batch is sharded across one thread per core, and each thread
+ * sums its gradient into a buffer of its own, which are reduced before
+ * the step. Every 16th position is held out to check the fit. Tuning
+ * starts from the bot's current weights (a weights file from an earlier
+ * run, if it loads one), and the result is written out for
+ * `team03_loadWeights`.
+ *
+ * Usage: ./tune <positions> <weights> [epochs] [result blend %] [rate]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "positions.h"
+
+#define TUNE_MAX_WORKERS 64
+#define TUNE_BATCH 16384 // records per step
+#define TUNE_HOLDOUT 16 // every this many records is held out
+#define TUNE_MAX_LABEL 512 // labels are clamped to +/- 64 discs (search
+                           // labels of won or lost games are far bigger)
+
+// Weights are laid out as the pattern tables by phase, then the
+// mobility, parity and stability weights by phase
+#define TUNE_TABLES (TEAM03_EVAL_PHASES * TEAM03_PATTERN_TABLE_SIZE)
+#define TUNE_MOBILITY TUNE_TABLES
+#define TUNE_PARITY (TUNE_MOBILITY + TEAM03_EVAL_PHASES)
+#define TUNE_STABILITY (TUNE_PARITY + TEAM03_EVAL_PHASES)
+#define TUNE_WEIGHTS (TUNE_STABILITY + TEAM03_EVAL_PHASES)
+
+/**
+ * A worker's share of a batch, and its gradient. The gradient is dense,
+ * but only the entries in `touched` are nonzero.
+ */
+typedef struct tune_worker {
+    const team03_record_t *recs;
+    long long first; // index of recs[0] in the file, for the holdout
+    int num;
+    float *grad;
+    int *touched, numTouched;
+    double trainLoss, testLoss;
+    long long trainCount, testCount;
+} tune_worker_t;
+
+// Run settings, and the weights with their AdaGrad sums
+double tune_blend, tune_rate;
+float *tune_weights, *tune_sums;
+tune_worker_t tune_workers[TUNE_MAX_WORKERS];
+int tune_numWorkers;
+
+/**
+ * Gets a record's features: the table entry of each pattern instance,
+ * and the mobility, parity and stability terms (from black's point of
+ * view).
+ *
+ * @param rec the record
+ * @param entries the TEAM03_PATTERNS weight indices to fill in
+ * @param mobility the mobility feature to set
+ * @param parity the parity feature to set
+ * @param stability the stability feature to set
+ *
+ * @return the record's phase
+ */
+int tune_features(const team03_record_t *rec, int *entries, float *mobility, float *parity, float *stability) {
+    board_t state = team03_recordBoard(rec);
+    team03_patterns_t patterns;
+    team03_computePatterns(&patterns, state);
+    
+    int discs = team03_popcount(state.on), phase = team03_evalPhase[discs];
+    for (int i = 0; i < TEAM03_PATTERNS; i++)
+        entries[i] = phase * TEAM03_PATTERN_TABLE_SIZE + patterns.indices[i];
+    
+    // Same as `team03_evaluateStatic`, from the side to move, then flipped
+    int color = rec->flags & TEAM03_RECORD_WHITE, sign = color ? -1 : 1;
+    *mobility = (float) (sign * (team03_computeMobility(state, color) - team03_computeMobility(state, !color)));
+    *parity = (float) (sign * ((discs & 1) ? 1 : -1));
+    *stability = (float) team03_getStableDiff(state, 0);
+    return phase;
+}
+
+/**
+ * Adds to an entry of a worker's gradient, noting it if it's new.
+ *
+ * @param worker the worker
+ * @param i the weight index
+ * @param g the amount to add
+ */
+void tune_accumulate(tune_worker_t *worker, int i, float g) {
+    if (worker->grad[i] == 0.0f) worker->touched[worker->numTouched++] = i;
+    worker->grad[i] += g;
+    if (worker->grad[i] == 0.0f) worker->grad[i] = 1e-30f; // keep it noted
+}
+
+/**
+ * Entry point for a worker thread: scores its share of the batch,
+ * summing the loss and the gradient of the training records.
+ *
+ * @param arg the worker
+ *
+ * @return NULL
+ */
+void *tune_work(void *arg) {
+    tune_worker_t *worker = arg;
+    int entries[TEAM03_PATTERNS];
+    float mobility, parity, stability;
+    
+    for (int n = 0; n < worker->num; n++) {
+        const team03_record_t *rec = &worker->recs[n];
+        int phase = tune_features(rec, entries, &mobility, &parity, &stability);
+        int label = rec->label < -TUNE_MAX_LABEL ? -TUNE_MAX_LABEL : rec->label > TUNE_MAX_LABEL ? TUNE_MAX_LABEL : rec->label;
+        double target = (1 - tune_blend) * label + tune_blend * 8 * rec->result;
+        double predicted = tune_weights[TUNE_MOBILITY + phase] * mobility
+                           + tune_weights[TUNE_PARITY + phase] * parity
+                           + tune_weights[TUNE_STABILITY + phase] * stability;
+        for (int i = 0; i < TEAM03_PATTERNS; i++) predicted += tune_weights[entries[i]];
+        
+        // Held out records only count towards the test loss
+        double error = predicted - target;
+        if ((worker->first + n) % TUNE_HOLDOUT == 0) {
+            worker->testLoss += error * error, worker->testCount++;
+            continue;
+        }
+        worker->trainLoss += error * error, worker->trainCount++;
+        for (int i = 0; i < TEAM03_PATTERNS; i++) tune_accumulate(worker, entries[i], (float) error);
+        tune_accumulate(worker, TUNE_MOBILITY + phase, (float) (error * mobility));
+        tune_accumulate(worker, TUNE_PARITY + phase, (float) (error * parity));
+        tune_accumulate(worker, TUNE_STABILITY + phase, (float) (error * stability));
+    }
+    return NULL;
+}
+
+/**
+ * Runs a batch: shards it across the workers, then reduces their
+ * gradients into the first worker's and takes an AdaGrad step on every
+ * weight that was touched.
+ *
+ * @param recs the batch
+ * @param first index of the batch's first record in the file
+ * @param num the number of records
+ */
+void tune_batch(const team03_record_t *recs, long long first, int num) {
+    pthread_t threads[TUNE_MAX_WORKERS];
+    int share = (num + tune_numWorkers - 1) / tune_numWorkers;
+    for (int t = 0; t < tune_numWorkers; t++) {
+        int start = t * share < num ? t * share : num;
+        tune_workers[t].recs = recs + start;
+        tune_workers[t].first = first + start;
+        tune_workers[t].num = (start + share < num ? start + share : num) - start;
+        if (t) pthread_create(&threads[t], NULL, tune_work, &tune_workers[t]);
+    }
+    tune_work(&tune_workers[0]);
+    for (int t = 1; t < tune_numWorkers; t++) pthread_join(threads[t], NULL);
+    
+    // Reduce into the first worker's gradient, clearing the others
+    tune_worker_t *total = &tune_workers[0];
+    for (int t = 1; t < tune_numWorkers; t++) {
+        tune_worker_t *worker = &tune_workers[t];
+        for (int k = 0; k < worker->numTouched; k++) {
+            int i = worker->touched[k];
+            tune_accumulate(total, i, worker->grad[i]);
+            worker->grad[i] = 0;
+        }
+        worker->numTouched = 0;
+    }
+    
+    // Step, clearing the total as we go
+    for (int k = 0; k < total->numTouched; k++) {
+        int i = total->touched[k];
+        float g = total->grad[i];
+        tune_sums[i] += g * g;
+        tune_weights[i] -= (float) (tune_rate * g / sqrt(tune_sums[i] + 1e-8));
+        total->grad[i] = 0;
+    }
+    total->numTouched = 0;
+}
+
+/**
+ * Runs an epoch: streams the file through a batch at a time.
+ *
+ * @param in the positions file
+ * @param recs room for a batch
+ *
+ * @return the number of records read
+ */
+long long tune_epoch(FILE *in, team03_record_t *recs) {
+    long long count = 0;
+    rewind(in);
+    for (;;) {
+        int num = 0;
+        while (num < TUNE_BATCH && team03_readRecord(in, &recs[num])) num++;
+        if (!num) break;
+        tune_batch(recs, count, num);
+        count += num;
+    }
+    return count;
+}
+
+/**
+ * Rounds the tuned weights into the bot's tables.
+ */
+void tune_store(void) {
+    for (int phase = 0; phase < TEAM03_EVAL_PHASES; phase++) {
+        for (int i = 0; i < TEAM03_PATTERN_TABLE_SIZE; i++)
+            team03_evalTable[phase][i] = team03_clampWeight((int) lrintf(tune_weights[phase * TEAM03_PATTERN_TABLE_SIZE + i]));
+        team03_mobilityWeights[phase] = (int) lrintf(tune_weights[TUNE_MOBILITY + phase]);
+        team03_parityWeights[phase] = (int) lrintf(tune_weights[TUNE_PARITY + phase]);
+        team03_stabilityWeights[phase] = (int) lrintf(tune_weights[TUNE_STABILITY + phase]);
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <positions> <weights> [epochs] [result blend %%] [rate]\n", argv[0]);
+        return 1;
+    }
+    int epochs = argc > 3 ? atoi(argv[3]) : 10;
+    tune_blend = (argc > 4 ? atoi(argv[4]) : 0) / 100.0;
+    tune_rate = argc > 5 ? atof(argv[5]) : 4.0;
+    FILE *in = fopen(argv[1], "rb");
+    if (!in) {
+        perror(argv[1]);
+        return 1;
+    }
+    
+    // Start from the bot's weights
+    team03_init();
+    tune_weights = malloc(sizeof(float) * TUNE_WEIGHTS);
+    tune_sums = calloc(TUNE_WEIGHTS, sizeof(float));
+    for (int phase = 0; phase < TEAM03_EVAL_PHASES; phase++) {
+        for (int i = 0; i < TEAM03_PATTERN_TABLE_SIZE; i++)
+            tune_weights[phase * TEAM03_PATTERN_TABLE_SIZE + i] = (float) team03_evalTable[phase][i];
+        tune_weights[TUNE_MOBILITY + phase] = (float) team03_mobilityWeights[phase];
+        tune_weights[TUNE_PARITY + phase] = (float) team03_parityWeights[phase];
+        tune_weights[TUNE_STABILITY + phase] = (float) team03_stabilityWeights[phase];
+    }
+    
+    // One worker per core
+    tune_numWorkers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (tune_numWorkers < 1) tune_numWorkers = 1;
+    if (tune_numWorkers > TUNE_MAX_WORKERS) tune_numWorkers = TUNE_MAX_WORKERS;
+    for (int t = 0; t < tune_numWorkers; t++) {
+        tune_workers[t].grad = calloc(TUNE_WEIGHTS, sizeof(float));
+        tune_workers[t].touched = malloc(sizeof(int) * (TUNE_WEIGHTS < TUNE_BATCH * (TEAM03_PATTERNS + 3)
+                                                        ? TUNE_WEIGHTS : TUNE_BATCH * (TEAM03_PATTERNS + 3)));
+    }
+    team03_record_t *recs = malloc(sizeof(team03_record_t) * TUNE_BATCH);
+    
+    // Loss is reported as the RMS error in discs
+    for (int epoch = 1; epoch <= epochs; epoch++) {
+        long long start = team03_nowMs(), count = tune_epoch(in, recs), took = team03_nowMs() - start;
+        double train = 0, test = 0;
+        long long trainCount = 0, testCount = 0;
+        for (int t = 0; t < tune_numWorkers; t++) {
+            train += tune_workers[t].trainLoss, trainCount += tune_workers[t].trainCount;
+            test += tune_workers[t].testLoss, testCount += tune_workers[t].testCount;
+            tune_workers[t].trainLoss = tune_workers[t].testLoss = 0;
+            tune_workers[t].trainCount = tune_workers[t].testCount = 0;
+        }
+        fprintf(stderr, "epoch %d: %lld positions in %lld ms, train rms %.3f, test rms %.3f (discs)\n",
+                epoch, count, took, sqrt(train / (trainCount ? trainCount : 1)) / 8,
+                sqrt(test / (testCount ? testCount : 1)) / 8);
+    }
+    fclose(in);
+    
+    tune_store();
+    if (!team03_saveWeights(argv[2])) {
+        perror(argv[2]);
+        return 1;
+    }
+    fprintf(stderr, "mobility by phase:");
+    for (int phase = 0; phase < TEAM03_EVAL_PHASES; phase++) fprintf(stderr, " %d", team03_mobilityWeights[phase]);
+    fprintf(stderr, "; parity by phase:");
+    for (int phase = 0; phase < TEAM03_EVAL_PHASES; phase++) fprintf(stderr, " %d", team03_parityWeights[phase]);
+    fprintf(stderr, "; stability by phase:");
+    for (int phase = 0; phase < TEAM03_EVAL_PHASES; phase++) fprintf(stderr, " %d", team03_stabilityWeights[phase]);
+    fprintf(stderr, "\nwrote %s\n", argv[2]);
+    return 0;
+}